@@ -27,6 +27,7 @@ RealTimeChris (Chris M.)
 #include <nihilus/common/concepts.hpp>
 #include <iostream>
 #include <cstdint>
+#include <cstring>
 #include <chrono>
 #include <thread>
 #include <mutex>
@@ -112,6 +113,22 @@ namespace nihilus {
 		}
 	};
 
+	NIHILUS_FORCE_INLINE uint64_t hash_bytes(const uint8_t* data, uint64_t size, uint64_t seed = 0xcbf29ce484222325ull) noexcept {
+		static constexpr uint64_t prime{ 0x100000001b3ull };
+		uint64_t hash = seed ^ size;
+		uint64_t x	  = 0;
+		for (; x + 8 <= size; x += 8) {
+			uint64_t word{};
+			std::memcpy(&word, data + x, sizeof(word));
+			hash = (hash ^ word) * prime;
+			hash ^= hash >> 29;
+		}
+		for (; x < size; ++x) {
+			hash = (hash ^ data[x]) * prime;
+		}
+		return hash;
+	}
+
 	static constexpr auto nanosecond_count{ 500 };
 
 	inline std::mutex mutex{};
@@ -694,6 +711,43 @@ namespace nihilus {
 
 	template<model_config config> using get_op_type_type_t = get_op_type_type<typename decltype(config)::model_size_type>::type;
 
+	enum class huge_page_mode : uint8_t {
+		none,
+		transparent,
+		huge_2mb,
+		huge_1gb,
+		count,
+	};
+
+	enum class thread_placement : uint8_t {
+		none,
+		cores,
+		l3,
+		explicit_list,
+		count,
+	};
+
+	enum class page_in_mode : uint8_t {
+		none,
+		advise,
+		touch,
+		count,
+	};
+
+	enum class prefetch_mode : uint8_t {
+		none,
+		readahead,
+		io_uring,
+		count,
+	};
+
+	enum class memory_lock_mode : uint8_t {
+		none,
+		weights,
+		weights_and_arena,
+		count,
+	};
+
 	struct cli_params {
 		uint64_t thread_count{ std::thread::hardware_concurrency() };
 		bool no_conversation{ false };
@@ -703,6 +757,25 @@ namespace nihilus {
 		uint64_t n_tokens{ 0 };
 		std::string prompt{};
 		uint64_t seed{ 0 };
+		uint64_t context_length{ 0 };
+		std::string kv_cache_file{};
+		uint64_t kv_hot_page_count{ 64 };
+		huge_page_mode huge_pages{ huge_page_mode::none };
+		bool numa{ false };
+		thread_placement placement{ thread_placement::none };
+		std::string cpu_list{};
+		bool high_priority{ false };
+		bool calibrate{ false };
+		bool use_smt{ false };
+		std::string weight_cache_file{};
+		bool repack_weights{ false };
+		page_in_mode page_in{ page_in_mode::touch };
+		bool stream_weights{ false };
+		prefetch_mode prefetch{ prefetch_mode::none };
+		memory_lock_mode lock_memory{ memory_lock_mode::none };
+		uint64_t token_cache_mb{ 64 };
+		std::string grammar_file{};
+		bool json_output{ false };
 	};
 
 	struct impl_indices {
@@ -714,8 +787,12 @@ namespace nihilus {
 		uint64_t num_threads{ std::thread::hardware_concurrency() };
 	};
 
+	struct grammar_constraint;
+
 	struct execution_parameters {
+		grammar_constraint* constraint{};
 		const int32_t* input_tokens{};
+		size_t input_token_count{};
 		size_t kv_cache_seq_len{};
 		size_t position_offset{};
 		size_t max_new_tokens{};
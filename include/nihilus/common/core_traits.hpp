@@ -22,6 +22,7 @@ RealTimeChris (Chris model_traits_type.)
 
 #include <nihilus/common/kernel_traits.hpp>
 #include <nihilus/common/kernel_type_profile_traits.hpp>
+#include <nihilus/common/sampling.hpp>
 #include <nihilus/common/model_traits.hpp>
 #include <nihilus/common/common.hpp>
 #include <nihilus/common/array.hpp>
@@ -88,7 +89,7 @@ namespace nihilus {
 		using model_traits_type													 = model_traits<config.arch, config.model_size, config.model_generation>;
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::input_token_type;
 		static constexpr uint64_t depth{ 0 };
-		static constexpr array<uint64_t, 4> dims{ { 1, 1, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::max_batch_size, 1, 1, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ round_up_to_multiple(type_traits<output_type>::total_byte_size(dims), 64ull) };
 		static constexpr layer_op_type layer_type{ layer_op_type::none };
@@ -396,6 +397,9 @@ namespace nihilus {
 		static constexpr llama_op_types type{ llama_op_types::cache_k };
 		static constexpr uint64_t count{ total_required_bytes / sizeof(output_type) };
 		array<output_type*, model_traits_type::block_count> data{};
+		// Set while the hierarchical kv_cache_tier is active; position p of a block then lives in pages[block][p / kv_cache_tier::page_token_count].
+		// Exposed for the paged attention kernels, which do not exist yet - nothing reads it so far.
+		array<output_type* const*, model_traits_type::block_count> pages{};
 		int32_t value{};
 	};
 
@@ -416,6 +420,9 @@ namespace nihilus {
 		static constexpr llama_op_types type{ llama_op_types::cache_v };
 		static constexpr uint64_t count{ total_required_bytes / sizeof(output_type) };
 		array<output_type*, model_traits_type::block_count> data{};
+		// Set while the hierarchical kv_cache_tier is active; position p of a block then lives in pages[block][p / kv_cache_tier::page_token_count].
+		// Exposed for the paged attention kernels, which do not exist yet - nothing reads it so far.
+		array<output_type* const*, model_traits_type::block_count> pages{};
 		int32_t value{};
 	};
 
@@ -453,7 +460,7 @@ namespace nihilus {
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::embedding_type;
 		static constexpr uint64_t depth{ std::max(input_type01::depth, input_type02::depth) + 1 };
 		static constexpr bool dequantization{ requires_dequant_or_quant<typename input_type01::output_type, typename input_type02::output_type>::required };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, 1, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, model_traits_type::max_batch_size, 1, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ round_up_to_multiple(
 			type_traits<output_type>::total_byte_size(dims) + (dequantization ? type_traits<output_type>::total_byte_size(dims) : 0), 64ull) };
@@ -478,7 +485,7 @@ namespace nihilus {
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::norm_output_type;
 		static constexpr uint64_t depth{ input_type01::depth + 1 };
 		static constexpr bool dequantization{ requires_dequant_or_quant<typename input_type01::output_type, output_type>::required };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, 1, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, model_traits_type::max_batch_size, 1, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ round_up_to_multiple(
 			type_traits<output_type>::total_byte_size(dims) + (dequantization ? type_traits<output_type>::total_byte_size(dims) : 0), 64ull) };
@@ -504,7 +511,7 @@ namespace nihilus {
 		using transform_type													 = output_transform<input_type01::krn_type, input_type02::krn_type>;
 		static constexpr uint64_t depth{ std::max(input_type01::depth, input_type02::depth) + 1 };
 		static constexpr bool dequantization{ requires_dequant_or_quant<typename input_type01::output_type, typename input_type02::output_type>::required };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, 1, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, model_traits_type::max_batch_size, 1, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ round_up_to_multiple(
 			type_traits<output_type>::total_byte_size(dims) + (dequantization ? type_traits<output_type>::total_byte_size(dims) : 0), 64ull) };
@@ -960,7 +967,7 @@ namespace nihilus {
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::value_type;
 		static constexpr uint64_t depth{ std::max(input_type01::depth, input_type02::depth) + 1 };
 		static constexpr bool dequantization{ requires_dequant_or_quant<typename input_type01::output_type, typename input_type02::output_type>::required };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::head_dim, 1, model_traits_type::head_count, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::head_dim, model_traits_type::max_batch_size, model_traits_type::head_count, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ round_up_to_multiple(
 			type_traits<output_type>::total_byte_size(dims) + (dequantization ? type_traits<output_type>::total_byte_size(dims) : 0), 64ull) };
@@ -986,7 +993,7 @@ namespace nihilus {
 		using input_type01														 = core_traits<config, llama_op_types::kqv>;
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::value_type;
 		static constexpr uint64_t depth{ input_type01::depth + 1 };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::head_dim, model_traits_type::head_count, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::head_dim, model_traits_type::head_count, model_traits_type::max_batch_size, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ 0 };
 		static constexpr layer_op_type layer_type{ layer_op_type::per_block };
@@ -1009,7 +1016,7 @@ namespace nihilus {
 		using input_type01														 = core_traits<config, llama_op_types::kqv_merged>;
 		using output_type														 = typename kernel_type_profile_traits<config.kernel_profile>::value_type;
 		static constexpr uint64_t depth{ input_type01::depth + 1 };
-		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, 1, 1, 1 } };
+		static constexpr array<uint64_t, 4> dims{ { model_traits_type::embedding_dim, model_traits_type::max_batch_size, 1, 1 } };
 		static constexpr array<size_t, 4> strides{ type_traits<output_type>::impl(dims) };
 		static constexpr uint64_t total_required_bytes{ 0 };
 		static constexpr layer_op_type layer_type{ layer_op_type::per_block };
@@ -1416,6 +1423,7 @@ namespace nihilus {
 		static constexpr llama_op_types type{ llama_op_types::result_output };
 		array<op_latch, model_traits_type::block_count> sync_flag_start;
 		array<op_latch, model_traits_type::block_count> sync_flag_end;
+		token_selector selector{};
 		static constexpr uint64_t count{ total_required_bytes / sizeof(output_type) };
 		output_type* data{};
 		int32_t value{};
@@ -0,0 +1,349 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/common.hpp>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <deque>
+
+#if defined(NIHILUS_PLATFORM_LINUX)
+	#include <sys/syscall.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+		#include <linux/io_uring.h>
+		#define NIHILUS_IO_URING 1
+	#endif
+#endif
+
+namespace nihilus {
+
+	struct file_prefetch_stats {
+		uint64_t bytes_requested{};
+		uint64_t bytes_completed{};
+		uint64_t bytes_in_flight{};
+		uint64_t bytes_dropped{};
+		uint64_t max_queue_depth{};
+		uint64_t queue_depth{};
+		uint64_t submissions{};
+		uint64_t errors{};
+	};
+
+	NIHILUS_FORCE_INLINE constexpr const char* get_prefetch_mode_name(prefetch_mode mode) {
+		switch (mode) {
+			case prefetch_mode::io_uring: {
+				return "io_uring";
+			}
+			case prefetch_mode::readahead: {
+				return "readahead";
+			}
+			default: {
+				return "none";
+			}
+		}
+	}
+
+#if defined(NIHILUS_IO_URING)
+	// Minimal raw-syscall io_uring - one submission and one completion ring, no liburing dependency.
+	struct io_uring_queue {
+		NIHILUS_FORCE_INLINE io_uring_queue() noexcept							 = default;
+		NIHILUS_FORCE_INLINE io_uring_queue& operator=(const io_uring_queue&) = delete;
+		NIHILUS_FORCE_INLINE io_uring_queue(const io_uring_queue&)			 = delete;
+
+		NIHILUS_FORCE_INLINE bool init(uint32_t entries) {
+			io_uring_params params{};
+			ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+			if (ring_fd < 0) {
+				ring_fd = -1;
+				return false;
+			}
+			sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			sqes_size	 = params.sq_entries * sizeof(io_uring_sqe);
+			sq_ring		 = map_region(sq_ring_size, IORING_OFF_SQ_RING);
+			cq_ring		 = map_region(cq_ring_size, IORING_OFF_CQ_RING);
+			sqes		 = static_cast<io_uring_sqe*>(map_region(sqes_size, IORING_OFF_SQES));
+			if (!sq_ring || !cq_ring || !sqes) {
+				deinit();
+				return false;
+			}
+			uint8_t* sq_bytes = static_cast<uint8_t*>(sq_ring);
+			uint8_t* cq_bytes = static_cast<uint8_t*>(cq_ring);
+			sq_tail			  = reinterpret_cast<uint32_t*>(sq_bytes + params.sq_off.tail);
+			sq_mask			  = *reinterpret_cast<uint32_t*>(sq_bytes + params.sq_off.ring_mask);
+			sq_array		  = reinterpret_cast<uint32_t*>(sq_bytes + params.sq_off.array);
+			cq_head			  = reinterpret_cast<uint32_t*>(cq_bytes + params.cq_off.head);
+			cq_tail			  = reinterpret_cast<uint32_t*>(cq_bytes + params.cq_off.tail);
+			cq_mask			  = *reinterpret_cast<uint32_t*>(cq_bytes + params.cq_off.ring_mask);
+			cqes			  = reinterpret_cast<io_uring_cqe*>(cq_bytes + params.cq_off.cqes);
+			capacity		  = params.sq_entries;
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t get_capacity() const noexcept {
+			return capacity;
+		}
+
+		NIHILUS_FORCE_INLINE void queue_fadvise(int file_descriptor, uint32_t size, uint64_t offset, uint32_t advice, uint64_t user_data) noexcept {
+			const uint32_t tail = std::atomic_ref<uint32_t>{ *sq_tail }.load(std::memory_order_relaxed);
+			const uint32_t index = tail & sq_mask;
+			io_uring_sqe& sqe	 = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode			= IORING_OP_FADVISE;
+			sqe.fd				= file_descriptor;
+			sqe.len				= size;
+			sqe.off				= offset;
+			sqe.fadvise_advice	= advice;
+			sqe.user_data		= user_data;
+			sq_array[index]		= index;
+			std::atomic_ref<uint32_t>{ *sq_tail }.store(tail + 1, std::memory_order_release);
+			++unsubmitted;
+		}
+
+		NIHILUS_FORCE_INLINE bool submit() noexcept {
+			if (unsubmitted == 0) {
+				return true;
+			}
+			const int result = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, unsubmitted, 0, 0, nullptr, 0));
+			if (result < 0) {
+				return false;
+			}
+			unsubmitted -= static_cast<uint32_t>(result);
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE bool wait_for_completion() noexcept {
+			return syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0;
+		}
+
+		template<typename function_type> NIHILUS_FORCE_INLINE uint64_t reap(function_type&& function) noexcept {
+			uint32_t head		= std::atomic_ref<uint32_t>{ *cq_head }.load(std::memory_order_relaxed);
+			const uint32_t tail = std::atomic_ref<uint32_t>{ *cq_tail }.load(std::memory_order_acquire);
+			uint64_t count{};
+			for (; head != tail; ++head, ++count) {
+				const io_uring_cqe& cqe = cqes[head & cq_mask];
+				function(cqe.user_data, cqe.res);
+			}
+			std::atomic_ref<uint32_t>{ *cq_head }.store(head, std::memory_order_release);
+			return count;
+		}
+
+		NIHILUS_FORCE_INLINE void deinit() noexcept {
+			unmap_region(sq_ring, sq_ring_size);
+			unmap_region(cq_ring, cq_ring_size);
+			unmap_region(sqes, sqes_size);
+			if (ring_fd != -1) {
+				close(ring_fd);
+				ring_fd = -1;
+			}
+		}
+
+		NIHILUS_FORCE_INLINE ~io_uring_queue() {
+			deinit();
+		}
+
+	  protected:
+		io_uring_sqe* sqes{};
+		io_uring_cqe* cqes{};
+		uint32_t* sq_array{};
+		uint32_t* sq_tail{};
+		uint32_t* cq_head{};
+		uint32_t* cq_tail{};
+		void* sq_ring{};
+		void* cq_ring{};
+		uint64_t sq_ring_size{};
+		uint64_t cq_ring_size{};
+		uint64_t sqes_size{};
+		uint32_t unsubmitted{};
+		uint32_t capacity{};
+		uint32_t sq_mask{};
+		uint32_t cq_mask{};
+		int ring_fd{ -1 };
+
+		NIHILUS_FORCE_INLINE void* map_region(uint64_t size, uint64_t offset) noexcept {
+			void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, static_cast<off_t>(offset));
+			return result == MAP_FAILED ? nullptr : result;
+		}
+
+		template<typename value_type> NIHILUS_FORCE_INLINE static void unmap_region(value_type*& region, uint64_t size) noexcept {
+			if (region) {
+				munmap(region, size);
+				region = nullptr;
+			}
+		}
+	};
+#endif
+
+	struct file_prefetch_chunk {
+		uint64_t offset{};
+		uint64_t size{};
+	};
+
+	// Pulls file ranges into the page cache ahead of the mapping's first touch, driven from the execution loop (see model::on_block_main). With
+	// io_uring each chunk is a POSIX_FADV_WILLNEED advice, so the kernel starts readahead without copying anything out and pages that are already
+	// resident cost nothing; each call reaps completions and tops the queue back up. A completion means the readahead was started, not that it
+	// finished, which is also all readahead(2) reports.
+	struct file_prefetcher {
+		static constexpr uint64_t chunk_bytes{ 1024ull * 1024ull };
+		static constexpr uint32_t queue_depth{ 64 };
+		static constexpr uint64_t max_pending_bytes{ 512ull * 1024ull * 1024ull };
+
+		NIHILUS_FORCE_INLINE file_prefetcher() noexcept							 = default;
+		NIHILUS_FORCE_INLINE file_prefetcher& operator=(const file_prefetcher&) = delete;
+		NIHILUS_FORCE_INLINE file_prefetcher(const file_prefetcher&)			 = delete;
+
+		NIHILUS_FORCE_INLINE bool init(std::string_view path, prefetch_mode mode_new) {
+			mode = mode_new;
+#if defined(NIHILUS_PLATFORM_LINUX)
+			const std::string path_string{ path };
+			file_descriptor = open(path_string.c_str(), O_RDONLY);
+			if (file_descriptor == -1) {
+				log<log_level::error>("file_prefetcher: failed to open " + path_string + ": " + std::string{ std::strerror(errno) });
+				mode = prefetch_mode::none;
+				return false;
+			}
+	#if defined(NIHILUS_IO_URING)
+			if (mode == prefetch_mode::io_uring) {
+				if (!ring.init(queue_depth)) {
+					log<log_level::status>("file_prefetcher: io_uring is unavailable (" + std::string{ std::strerror(errno) } + "), falling back to readahead.");
+					mode = prefetch_mode::readahead;
+				}
+			}
+	#else
+			if (mode == prefetch_mode::io_uring) {
+				mode = prefetch_mode::readahead;
+			}
+	#endif
+			log<log_level::status>("file_prefetcher: prefetching weights with " + std::string{ get_prefetch_mode_name(mode) } + ".");
+			return true;
+#else
+			( void )path;
+			mode = prefetch_mode::none;
+			return false;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return mode != prefetch_mode::none;
+		}
+
+		NIHILUS_FORCE_INLINE void prefetch(uint64_t offset, uint64_t size) {
+			if (mode == prefetch_mode::none || size == 0) {
+				return;
+			}
+			stats.bytes_requested += size;
+			if (mode == prefetch_mode::readahead) {
+#if defined(NIHILUS_PLATFORM_LINUX)
+				if (readahead(file_descriptor, static_cast<off_t>(offset), size) != 0) {
+					++stats.errors;
+				}
+				++stats.submissions;
+#endif
+				return;
+			}
+			for (uint64_t x = 0; x < size; x += chunk_bytes) {
+				pending.emplace_back(file_prefetch_chunk{ offset + x, std::min(chunk_bytes, size - x) });
+				pending_bytes += pending.back().size;
+			}
+			// When the disk falls behind, the oldest queued ranges are the ones execution has already passed.
+			while (pending_bytes > max_pending_bytes) {
+				pending_bytes -= pending.front().size;
+				stats.bytes_dropped += pending.front().size;
+				pending.pop_front();
+			}
+		}
+
+		// Reaps finished reads and submits queued ones up to the queue depth; never blocks.
+		NIHILUS_FORCE_INLINE void pump() {
+#if defined(NIHILUS_IO_URING)
+			if (mode != prefetch_mode::io_uring) {
+				return;
+			}
+			ring.reap([&](uint64_t user_data, int32_t result) {
+				--stats.queue_depth;
+				stats.bytes_in_flight -= user_data;
+				if (result < 0) {
+					++stats.errors;
+				} else {
+					stats.bytes_completed += user_data;
+				}
+			});
+			while (!pending.empty() && stats.queue_depth < ring.get_capacity()) {
+				const file_prefetch_chunk chunk = pending.front();
+				pending.pop_front();
+				pending_bytes -= chunk.size;
+				ring.queue_fadvise(file_descriptor, static_cast<uint32_t>(chunk.size), chunk.offset, POSIX_FADV_WILLNEED, chunk.size);
+				++stats.queue_depth;
+				++stats.submissions;
+				stats.bytes_in_flight += chunk.size;
+			}
+			stats.max_queue_depth = std::max(stats.max_queue_depth, stats.queue_depth);
+			if (!ring.submit()) {
+				++stats.errors;
+			}
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE const file_prefetch_stats& get_stats() const noexcept {
+			return stats;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() const {
+			log<log_level::status>("file_prefetcher: " + std::string{ get_prefetch_mode_name(mode) } + ", requested " +
+				std::to_string(stats.bytes_requested / (1024ull * 1024ull)) + " MB, completed " + std::to_string(stats.bytes_completed / (1024ull * 1024ull)) +
+				" MB, in flight " + std::to_string(stats.bytes_in_flight / (1024ull * 1024ull)) + " MB, dropped " +
+				std::to_string(stats.bytes_dropped / (1024ull * 1024ull)) + " MB, queue depth " + std::to_string(stats.queue_depth) + " (max " +
+				std::to_string(stats.max_queue_depth) + "), " + std::to_string(stats.submissions) + " submissions, " + std::to_string(stats.errors) + " errors.");
+		}
+
+		NIHILUS_FORCE_INLINE ~file_prefetcher() {
+#if defined(NIHILUS_IO_URING)
+			// Outstanding advice still references file_descriptor, so it is drained before the descriptor is closed.
+			pending.clear();
+			pending_bytes = 0;
+			while (mode == prefetch_mode::io_uring && stats.queue_depth > 0 && ring.wait_for_completion()) {
+				pump();
+			}
+			ring.deinit();
+#endif
+#if defined(NIHILUS_PLATFORM_LINUX)
+			if (file_descriptor != -1) {
+				close(file_descriptor);
+			}
+#endif
+		}
+
+	  protected:
+#if defined(NIHILUS_IO_URING)
+		io_uring_queue ring{};
+#endif
+		std::deque<file_prefetch_chunk> pending{};
+		prefetch_mode mode{ prefetch_mode::none };
+		file_prefetch_stats stats{};
+		uint64_t pending_bytes{};
+		int file_descriptor{ -1 };
+	};
+
+}
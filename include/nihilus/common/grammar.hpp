@@ -0,0 +1,888 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+
+#pragma once
+
+#include <nihilus/common/unicode.hpp>
+#include <nihilus/common/common.hpp>
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <span>
+
+namespace nihilus {
+
+	// JSON with a bounded amount of whitespace, so a model that is done cannot pad forever.
+	inline constexpr std::string_view json_grammar{ R"gbnf(
+root   ::= object
+value  ::= object | array | string | number | ("true" | "false" | "null") ws
+
+object ::=
+  "{" ws (
+            string ":" ws value
+    ("," ws string ":" ws value)*
+  )? "}" ws
+
+array  ::=
+  "[" ws (
+            value
+    ("," ws value)*
+  )? "]" ws
+
+string ::=
+  "\"" (
+    [^"\\\x7F\x00-\x1F] |
+    "\\" (["\\/bfnrt] | "u" [0-9a-fA-F]{4})
+  )* "\"" ws
+
+number ::= ("-"? ([0-9] | [1-9] [0-9]{0,15})) ("." [0-9]+)? ([eE] [-+]? [0-9] [1-9]{0,15})? ws
+
+ws ::= | " " | "\n" [ \t]{0,20}
+)gbnf" };
+
+	enum class grammar_element_type : uint8_t {
+		end,
+		rule_ref,
+		char_set,
+	};
+
+	struct grammar_element {
+		grammar_element_type type{};
+		uint32_t value{};
+	};
+
+	struct grammar_char_set {
+		std::vector<std::pair<uint32_t, uint32_t>> ranges{};
+		bool negated{};
+
+		NIHILUS_FORCE_INLINE bool matches(uint32_t code_point) const noexcept {
+			for (const auto& range: ranges) {
+				if (code_point >= range.first && code_point <= range.second) {
+					return !negated;
+				}
+			}
+			return negated;
+		}
+
+		NIHILUS_FORCE_INLINE bool matches_non_ascii() const noexcept {
+			return negated || std::any_of(ranges.begin(), ranges.end(), [](const auto& range) {
+				return range.second >= 0x80;
+			});
+		}
+	};
+
+	// A GBNF grammar (the llama.cpp dialect: rules, literals, character classes, '.', groups, * + ? and {m,n}) compiled to flat element runs. Every
+	// alternative is a run of elements closed by an end element; repetitions and groups become generated rules, so the runtime only ever sees
+	// character sets and rule references. Left recursion is rejected up front because the stack expansion would never terminate on it.
+	struct grammar {
+		NIHILUS_FORCE_INLINE bool parse(std::string_view source) {
+			text	 = source;
+			position = 0;
+			rule_ids.clear();
+			rule_names.clear();
+			rule_defined.clear();
+			rules.clear();
+			char_sets.clear();
+			skip_space(true);
+			while (position < text.size()) {
+				const std::string_view name = parse_name();
+				if (name.empty()) {
+					return fail("expected a rule name");
+				}
+				skip_space(false);
+				if (text.substr(position, 3) != "::=") {
+					return fail("expected ::= after " + std::string{ name });
+				}
+				position += 3;
+				skip_space(true);
+				const uint32_t rule = get_rule_id(name);
+				if (rule_defined[rule]) {
+					return fail("rule " + std::string{ name } + " is defined twice");
+				}
+				rule_defined[rule] = true;
+				if (!parse_alternatives(rule, false)) {
+					return false;
+				}
+				if (position < text.size() && text[position] != '\n') {
+					return fail("unexpected character");
+				}
+				skip_space(true);
+			}
+			for (uint64_t x = 0; x < rule_names.size(); ++x) {
+				if (!rule_defined[x]) {
+					return fail("rule " + rule_names[x] + " is referenced but never defined");
+				}
+			}
+			if (auto iter = rule_ids.find("root"); iter != rule_ids.end()) {
+				root = iter->second;
+			} else {
+				return fail("no root rule");
+			}
+			flatten();
+			if (const int64_t rule = find_left_recursion(); rule >= 0) {
+				return fail("rule " + rule_names[static_cast<uint64_t>(rule)] + " is left recursive");
+			}
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE const grammar_element& get_element(uint32_t index) const noexcept {
+			return elements[index];
+		}
+
+		NIHILUS_FORCE_INLINE const grammar_char_set& get_char_set(uint32_t index) const noexcept {
+			return char_sets[index];
+		}
+
+		// Indices of the first element of each alternative of rule.
+		NIHILUS_FORCE_INLINE std::span<const uint32_t> get_alternatives(uint32_t rule) const noexcept {
+			return { alternative_starts.data() + rule_offsets[rule], rule_offsets[rule + 1] - rule_offsets[rule] };
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t get_root() const noexcept {
+			return root;
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t rule_count() const noexcept {
+			return rule_names.size();
+		}
+
+	  protected:
+		using sequence_type = std::vector<grammar_element>;
+		static constexpr uint32_t unbounded{ std::numeric_limits<uint32_t>::max() };
+
+		std::unordered_map<std::string, uint32_t> rule_ids{};
+		std::vector<std::string> rule_names{};
+		std::vector<uint8_t> rule_defined{};
+		std::vector<std::vector<sequence_type>> rules{};
+		std::vector<grammar_char_set> char_sets{};
+		std::vector<grammar_element> elements{};
+		std::vector<uint32_t> alternative_starts{};
+		std::vector<uint32_t> rule_offsets{};
+		std::string_view text{};
+		uint64_t position{};
+		uint32_t root{};
+
+		NIHILUS_FORCE_INLINE bool fail(const std::string& reason) {
+			const uint64_t line = static_cast<uint64_t>(std::count(text.begin(), text.begin() + static_cast<int64_t>(std::min(position, text.size())), '\n')) + 1;
+			log<log_level::error>("grammar: " + reason + " (line " + std::to_string(line) + ")");
+			return false;
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t get_rule_id(std::string_view name) {
+			const auto [iter, inserted] = rule_ids.try_emplace(std::string{ name }, static_cast<uint32_t>(rule_names.size()));
+			if (inserted) {
+				rule_names.emplace_back(name);
+				rule_defined.emplace_back(false);
+				rules.emplace_back();
+			}
+			return iter->second;
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t new_rule(uint32_t parent) {
+			const uint32_t rule = get_rule_id(rule_names[parent] + "_" + std::to_string(rule_names.size()));
+			rule_defined[rule]	= true;
+			return rule;
+		}
+
+		NIHILUS_FORCE_INLINE static bool is_name_char(char value) noexcept {
+			return (value >= 'a' && value <= 'z') || (value >= 'A' && value <= 'Z') || (value >= '0' && value <= '9') || value == '-' || value == '_';
+		}
+
+		NIHILUS_FORCE_INLINE void skip_space(bool newlines) noexcept {
+			while (position < text.size()) {
+				const char value = text[position];
+				if (value == ' ' || value == '\t' || value == '\r' || (value == '\n' && newlines)) {
+					++position;
+				} else if (value == '#') {
+					while (position < text.size() && text[position] != '\n') {
+						++position;
+					}
+				} else {
+					break;
+				}
+			}
+		}
+
+		NIHILUS_FORCE_INLINE std::string_view parse_name() noexcept {
+			const uint64_t start = position;
+			while (position < text.size() && is_name_char(text[position])) {
+				++position;
+			}
+			return text.substr(start, position - start);
+		}
+
+		NIHILUS_FORCE_INLINE bool parse_hex(uint64_t digits, uint32_t& value) {
+			value = 0;
+			for (uint64_t x = 0; x < digits; ++x, ++position) {
+				if (position >= text.size()) {
+					return fail("truncated escape");
+				}
+				const char digit = text[position];
+				const uint32_t nibble = digit >= '0' && digit <= '9' ? static_cast<uint32_t>(digit - '0')
+					: digit >= 'a' && digit <= 'f'					  ? static_cast<uint32_t>(digit - 'a' + 10)
+					: digit >= 'A' && digit <= 'F'					  ? static_cast<uint32_t>(digit - 'A' + 10)
+																	  : 16;
+				if (nibble == 16) {
+					return fail("invalid hex escape");
+				}
+				value = value * 16 + nibble;
+			}
+			return true;
+		}
+
+		// One code point of a literal or a character class, with escapes resolved.
+		NIHILUS_FORCE_INLINE bool parse_char(uint32_t& value) {
+			if (position >= text.size()) {
+				return fail("unterminated literal");
+			}
+			if (text[position] != '\\') {
+				const utf8_code_point code_point = decode_utf8(text.data() + position, text.size() - position);
+				value							 = code_point.value;
+				position += code_point.length;
+				return true;
+			}
+			if (++position >= text.size()) {
+				return fail("truncated escape");
+			}
+			const char escape = text[position++];
+			switch (escape) {
+				case 'n':
+					value = '\n';
+					return true;
+				case 'r':
+					value = '\r';
+					return true;
+				case 't':
+					value = '\t';
+					return true;
+				case 'x':
+					return parse_hex(2, value);
+				case 'u':
+					return parse_hex(4, value);
+				case 'U':
+					return parse_hex(8, value);
+				default:
+					value = static_cast<uint8_t>(escape);
+					return true;
+			}
+		}
+
+		NIHILUS_FORCE_INLINE grammar_element add_char_set(grammar_char_set&& set) {
+			char_sets.emplace_back(std::move(set));
+			return grammar_element{ grammar_element_type::char_set, static_cast<uint32_t>(char_sets.size() - 1) };
+		}
+
+		inline bool parse_alternatives(uint32_t rule, bool nested) {
+			std::vector<sequence_type> alternatives{};
+			while (true) {
+				sequence_type sequence{};
+				if (!parse_sequence(rule, nested, sequence)) {
+					return false;
+				}
+				alternatives.emplace_back(std::move(sequence));
+				skip_space(nested);
+				if (position >= text.size() || text[position] != '|') {
+					break;
+				}
+				++position;
+				skip_space(true);
+			}
+			rules[rule] = std::move(alternatives);
+			return true;
+		}
+
+		inline bool parse_sequence(uint32_t rule, bool nested, sequence_type& sequence) {
+			uint64_t symbol_start = 0;
+			while (true) {
+				skip_space(nested);
+				if (position >= text.size()) {
+					return true;
+				}
+				const char value = text[position];
+				if (value == '"') {
+					++position;
+					symbol_start = sequence.size();
+					while (position < text.size() && text[position] != '"') {
+						uint32_t code_point{};
+						if (!parse_char(code_point)) {
+							return false;
+						}
+						sequence.emplace_back(add_char_set(grammar_char_set{ { { code_point, code_point } }, false }));
+					}
+					if (position++ >= text.size()) {
+						return fail("unterminated literal");
+					}
+				} else if (value == '[') {
+					++position;
+					grammar_char_set set{};
+					if (position < text.size() && text[position] == '^') {
+						set.negated = true;
+						++position;
+					}
+					while (position < text.size() && text[position] != ']') {
+						uint32_t lower{};
+						uint32_t upper{};
+						if (!parse_char(lower)) {
+							return false;
+						}
+						upper = lower;
+						if (position + 1 < text.size() && text[position] == '-' && text[position + 1] != ']') {
+							++position;
+							if (!parse_char(upper)) {
+								return false;
+							}
+						}
+						set.ranges.emplace_back(lower, upper);
+					}
+					if (position++ >= text.size()) {
+						return fail("unterminated character class");
+					}
+					symbol_start = sequence.size();
+					sequence.emplace_back(add_char_set(std::move(set)));
+				} else if (value == '.') {
+					++position;
+					symbol_start = sequence.size();
+					sequence.emplace_back(add_char_set(grammar_char_set{ {}, true }));
+				} else if (value == '(') {
+					++position;
+					skip_space(true);
+					const uint32_t group = new_rule(rule);
+					if (!parse_alternatives(group, true)) {
+						return false;
+					}
+					skip_space(true);
+					if (position >= text.size() || text[position] != ')') {
+						return fail("expected )");
+					}
+					++position;
+					symbol_start = sequence.size();
+					sequence.emplace_back(grammar_element{ grammar_element_type::rule_ref, group });
+				} else if (value == '*' || value == '+' || value == '?' || value == '{') {
+					if (symbol_start >= sequence.size()) {
+						return fail("repetition without a preceding symbol");
+					}
+					++position;
+					uint32_t minimum = value == '+' ? 1 : 0;
+					uint32_t maximum = value == '?' ? 1 : unbounded;
+					if (value == '{' && !parse_bounds(minimum, maximum)) {
+						return false;
+					}
+					repeat(rule, sequence, symbol_start, minimum, maximum);
+				} else if (is_name_char(value)) {
+					const std::string_view name = parse_name();
+					symbol_start				= sequence.size();
+					sequence.emplace_back(grammar_element{ grammar_element_type::rule_ref, get_rule_id(name) });
+				} else {
+					return true;
+				}
+			}
+		}
+
+		NIHILUS_FORCE_INLINE bool parse_number(uint32_t& value) {
+			const uint64_t start = position;
+			value				 = 0;
+			while (position < text.size() && text[position] >= '0' && text[position] <= '9') {
+				value = value * 10 + static_cast<uint32_t>(text[position++] - '0');
+			}
+			return position > start;
+		}
+
+		// {m}, {m,} or {m,n}, with the opening brace already consumed.
+		NIHILUS_FORCE_INLINE bool parse_bounds(uint32_t& minimum, uint32_t& maximum) {
+			skip_space(false);
+			if (!parse_number(minimum)) {
+				return fail("expected a repetition count");
+			}
+			skip_space(false);
+			maximum = minimum;
+			if (position < text.size() && text[position] == ',') {
+				++position;
+				skip_space(false);
+				if (!parse_number(maximum)) {
+					maximum = unbounded;
+				}
+				skip_space(false);
+			}
+			if (position >= text.size() || text[position] != '}' || maximum < minimum) {
+				return fail("malformed repetition bounds");
+			}
+			++position;
+			return true;
+		}
+
+		// X{m,n} becomes m copies of X followed by a chain of optional copies, X{m,} by m copies and a right-recursive tail.
+		NIHILUS_FORCE_INLINE void repeat(uint32_t rule, sequence_type& sequence, uint64_t symbol_start, uint32_t minimum, uint32_t maximum) {
+			const sequence_type symbol(sequence.begin() + static_cast<int64_t>(symbol_start), sequence.end());
+			sequence.resize(symbol_start);
+			for (uint32_t x = 0; x < minimum; ++x) {
+				sequence.insert(sequence.end(), symbol.begin(), symbol.end());
+			}
+			if (maximum == unbounded) {
+				const uint32_t tail = new_rule(rule);
+				sequence_type recursive{ symbol };
+				recursive.emplace_back(grammar_element{ grammar_element_type::rule_ref, tail });
+				rules[tail] = { std::move(recursive), sequence_type{} };
+				sequence.emplace_back(grammar_element{ grammar_element_type::rule_ref, tail });
+				return;
+			}
+			int64_t next{ -1 };
+			for (uint32_t x = minimum; x < maximum; ++x) {
+				const uint32_t optional = new_rule(rule);
+				sequence_type present{ symbol };
+				if (next >= 0) {
+					present.emplace_back(grammar_element{ grammar_element_type::rule_ref, static_cast<uint32_t>(next) });
+				}
+				rules[optional] = { std::move(present), sequence_type{} };
+				next			= optional;
+			}
+			if (next >= 0) {
+				sequence.emplace_back(grammar_element{ grammar_element_type::rule_ref, static_cast<uint32_t>(next) });
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void flatten() {
+			elements.clear();
+			alternative_starts.clear();
+			rule_offsets.assign(1, 0);
+			for (const auto& alternatives: rules) {
+				for (const auto& sequence: alternatives) {
+					alternative_starts.emplace_back(static_cast<uint32_t>(elements.size()));
+					elements.insert(elements.end(), sequence.begin(), sequence.end());
+					elements.emplace_back(grammar_element{ grammar_element_type::end, 0 });
+				}
+				rule_offsets.emplace_back(static_cast<uint32_t>(alternative_starts.size()));
+			}
+		}
+
+		// A rule is left recursive if it can reach itself through references that are each preceded only by nullable elements.
+		NIHILUS_FORCE_INLINE int64_t find_left_recursion() const {
+			std::vector<uint8_t> nullable(rules.size());
+			for (bool changed = true; changed;) {
+				changed = false;
+				for (uint64_t x = 0; x < rules.size(); ++x) {
+					if (nullable[x]) {
+						continue;
+					}
+					for (const uint32_t start: get_alternatives(static_cast<uint32_t>(x))) {
+						uint32_t y = start;
+						while (elements[y].type == grammar_element_type::rule_ref && nullable[elements[y].value]) {
+							++y;
+						}
+						if (elements[y].type == grammar_element_type::end) {
+							nullable[x] = changed = true;
+							break;
+						}
+					}
+				}
+			}
+			std::vector<uint8_t> marks(rules.size());
+			const auto visit = [&](const auto& self, uint32_t rule) -> bool {
+				if (marks[rule] == 1) {
+					return true;
+				}
+				if (marks[rule] == 2) {
+					return false;
+				}
+				marks[rule] = 1;
+				for (const uint32_t start: get_alternatives(rule)) {
+					for (uint32_t y = start; elements[y].type == grammar_element_type::rule_ref; ++y) {
+						if (self(self, elements[y].value)) {
+							return true;
+						}
+						if (!nullable[elements[y].value]) {
+							break;
+						}
+					}
+				}
+				marks[rule] = 2;
+				return false;
+			};
+			for (uint64_t x = 0; x < rules.size(); ++x) {
+				if (visit(visit, static_cast<uint32_t>(x))) {
+					return static_cast<int64_t>(x);
+				}
+			}
+			return -1;
+		}
+	};
+
+	struct grammar_mask_stats {
+		uint64_t lookups{};
+		uint64_t hits{};
+		uint64_t states{};
+		uint64_t stacks{};
+	};
+
+	// Token-level constraint over a compiled grammar. A parse position is a set of stacks of element indices; stacks are hash-consed into a shared
+	// tree and stack sets are interned, so a position is a single id and the per-code-point transitions between ids are memoized - the grammar is
+	// lazily determinized as generation visits it. The token mask of a position is computed once by walking a byte trie of the vocabulary from that
+	// position (pruning every subtree the grammar rejects) and cached, so once a state has been seen its mask costs a hash lookup regardless of the
+	// vocabulary size. Token bytes are decoded as UTF-8 along the way; a token may end inside a code point, in which case the partial sequence is
+	// carried into the next token.
+	struct grammar_constraint {
+		NIHILUS_FORCE_INLINE bool init(std::string_view source, const std::vector<std::string_view>& pieces_new, int32_t end_token_new, uint64_t row_size,
+			uint64_t cache_bytes = 64ull * 1024ull * 1024ull) {
+			if (!rules.parse(source)) {
+				return false;
+			}
+			pieces	   = pieces_new;
+			end_token  = end_token_new;
+			mask_words = (std::max<uint64_t>(row_size, pieces.size()) + 63) / 64;
+			mask_capacity = std::max<uint64_t>(cache_bytes / (mask_words * sizeof(uint64_t)), 1);
+			init_trie();
+			stack_nodes.assign(1, stack_node{});
+			stack_ids.clear();
+			sets.clear();
+			set_members.clear();
+			set_ids.clear();
+			transitions.clear();
+			mask_slots.clear();
+			mask_storage.clear();
+			use_counter = 0;
+			stats		= {};
+			scratch_stacks.clear();
+			intern_set(scratch_stacks);
+			for (const uint32_t start: rules.get_alternatives(rules.get_root())) {
+				expand(rules.get_element(start).type == grammar_element_type::end ? 0 : push_stack(start, 0), scratch_stacks);
+			}
+			initial_set = intern_set(scratch_stacks);
+			reset();
+			log<log_level::status>("grammar: " + std::to_string(rules.rule_count()) + " rules, token trie of " + std::to_string(trie.size()) + " nodes.");
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return initial_set != 0;
+		}
+
+		NIHILUS_FORCE_INLINE void reset() noexcept {
+			current = parse_state{ initial_set, 0, 0 };
+		}
+
+		NIHILUS_FORCE_INLINE int32_t get_end_token() const noexcept {
+			return end_token;
+		}
+
+		// The grammar has matched a complete root and the end token is allowed.
+		NIHILUS_FORCE_INLINE bool is_complete() const noexcept {
+			return current.pending_length == 0 && sets[current.set].accepting;
+		}
+
+		// One bit per vocabulary entry, set where the token may come next; valid until the next call.
+		NIHILUS_FORCE_INLINE const uint64_t* get_mask() {
+			++stats.lookups;
+			const uint64_t key = (static_cast<uint64_t>(current.set) << 32) | (static_cast<uint64_t>(current.pending_length) << 24) | current.pending_value;
+			if (auto iter = mask_slots.find(key); iter != mask_slots.end()) {
+				++stats.hits;
+				iter->second.last_use = ++use_counter;
+				return mask_storage.data() + iter->second.slot * mask_words;
+			}
+			uint64_t slot = mask_slots.size();
+			if (auto oldest = mask_slots.begin(); slot >= mask_capacity && oldest != mask_slots.end()) {
+				for (auto iterator = std::next(oldest); iterator != mask_slots.end(); ++iterator) {
+					if (iterator->second.last_use < oldest->second.last_use) {
+						oldest = iterator;
+					}
+				}
+				slot = oldest->second.slot;
+				mask_slots.erase(oldest);
+			} else {
+				mask_storage.resize((slot + 1) * mask_words);
+			}
+			uint64_t* mask = mask_storage.data() + slot * mask_words;
+			std::fill(mask, mask + mask_words, 0ull);
+			walk_trie(0, current, mask);
+			if (end_token >= 0 && static_cast<uint64_t>(end_token) < mask_words * 64 && is_complete()) {
+				mask[static_cast<uint64_t>(end_token) >> 6] |= 1ull << (static_cast<uint64_t>(end_token) & 63);
+			}
+			mask_slots.emplace(key, mask_slot{ slot, ++use_counter });
+			return mask;
+		}
+
+		// Advances past token; returns false and leaves the position unchanged if the grammar does not allow it.
+		NIHILUS_FORCE_INLINE bool accept(int32_t token) {
+			if (token == end_token) {
+				return is_complete();
+			}
+			if (token < 0 || static_cast<uint64_t>(token) >= pieces.size() || pieces[static_cast<uint64_t>(token)].empty()) {
+				return false;
+			}
+			parse_state state{ current };
+			for (const char byte: pieces[static_cast<uint64_t>(token)]) {
+				if (!advance(state, static_cast<uint8_t>(byte))) {
+					return false;
+				}
+			}
+			if (state.pending_length != 0 && !sets[state.set].non_ascii) {
+				return false;
+			}
+			current = state;
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE grammar_mask_stats get_stats() const noexcept {
+			grammar_mask_stats result{ stats };
+			result.states = sets.size();
+			result.stacks = stack_nodes.size();
+			return result;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() const {
+			const grammar_mask_stats current_stats = get_stats();
+			log<log_level::status>("grammar: " + std::to_string(current_stats.hits) + "/" + std::to_string(current_stats.lookups) + " mask cache hits, " +
+				std::to_string(current_stats.states) + " parse states, " + std::to_string(current_stats.stacks) + " stack nodes.");
+		}
+
+	  protected:
+		struct stack_node {
+			uint32_t element{};
+			uint32_t parent{};
+		};
+
+		struct stack_set {
+			uint32_t begin{};
+			uint32_t count{};
+			bool accepting{};
+			bool non_ascii{};
+		};
+
+		// Set 0 is the dead position, stack 0 the empty stack (a complete root).
+		struct parse_state {
+			uint32_t set{};
+			uint32_t pending_length{};
+			uint32_t pending_value{};
+		};
+
+		struct trie_node {
+			uint32_t first_child{};
+			uint32_t next_sibling{};
+			uint32_t token_begin{};
+			uint32_t token_count{};
+			uint8_t byte{};
+		};
+
+		struct mask_slot {
+			uint64_t slot{};
+			uint64_t last_use{};
+		};
+
+		grammar rules{};
+		std::vector<std::string_view> pieces{};
+		std::vector<stack_node> stack_nodes{};
+		std::unordered_map<uint64_t, uint32_t> stack_ids{};
+		std::vector<stack_set> sets{};
+		std::vector<uint32_t> set_members{};
+		std::unordered_multimap<uint64_t, uint32_t> set_ids{};
+		std::unordered_map<uint64_t, uint32_t> transitions{};
+		std::vector<uint32_t> scratch_stacks{};
+		std::vector<trie_node> trie{};
+		std::vector<int32_t> trie_tokens{};
+		std::unordered_map<uint64_t, mask_slot> mask_slots{};
+		std::vector<uint64_t> mask_storage{};
+		grammar_mask_stats stats{};
+		parse_state current{};
+		uint64_t mask_capacity{};
+		uint64_t mask_words{};
+		uint64_t use_counter{};
+		uint32_t initial_set{};
+		int32_t end_token{ -1 };
+
+		NIHILUS_FORCE_INLINE uint32_t push_stack(uint32_t element, uint32_t parent) {
+			const uint64_t key			= (static_cast<uint64_t>(element) << 32) | parent;
+			const auto [iter, inserted] = stack_ids.try_emplace(key, static_cast<uint32_t>(stack_nodes.size()));
+			if (inserted) {
+				stack_nodes.emplace_back(stack_node{ element, parent });
+			}
+			return iter->second;
+		}
+
+		// Pops the element on top of stack and pushes the element after it, unless that closes the alternative.
+		NIHILUS_FORCE_INLINE uint32_t step_stack(uint32_t stack) {
+			const stack_node node = stack_nodes[stack];
+			return rules.get_element(node.element + 1).type == grammar_element_type::end ? node.parent : push_stack(node.element + 1, node.parent);
+		}
+
+		// Rewrites stack until its top is a character set (or it is empty), branching once per alternative of every rule reference on top.
+		inline void expand(uint32_t stack, std::vector<uint32_t>& output) {
+			if (stack == 0 || rules.get_element(stack_nodes[stack].element).type == grammar_element_type::char_set) {
+				output.emplace_back(stack);
+				return;
+			}
+			const uint32_t rule = rules.get_element(stack_nodes[stack].element).value;
+			const uint32_t base = step_stack(stack);
+			for (const uint32_t start: rules.get_alternatives(rule)) {
+				expand(rules.get_element(start).type == grammar_element_type::end ? base : push_stack(start, base), output);
+			}
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t intern_set(std::vector<uint32_t>& stacks) {
+			std::sort(stacks.begin(), stacks.end());
+			stacks.erase(std::unique(stacks.begin(), stacks.end()), stacks.end());
+			if (stacks.empty() && !sets.empty()) {
+				return 0;
+			}
+			const uint64_t hash = hash_bytes(reinterpret_cast<const uint8_t*>(stacks.data()), stacks.size() * sizeof(uint32_t));
+			for (auto [iter, last] = set_ids.equal_range(hash); iter != last; ++iter) {
+				const stack_set& set = sets[iter->second];
+				if (set.count == stacks.size() && std::equal(stacks.begin(), stacks.end(), set_members.begin() + set.begin)) {
+					return iter->second;
+				}
+			}
+			stack_set set{ static_cast<uint32_t>(set_members.size()), static_cast<uint32_t>(stacks.size()), false, false };
+			for (const uint32_t stack: stacks) {
+				set.accepting |= stack == 0;
+				set.non_ascii |= stack != 0 && rules.get_char_set(rules.get_element(stack_nodes[stack].element).value).matches_non_ascii();
+			}
+			set_members.insert(set_members.end(), stacks.begin(), stacks.end());
+			sets.emplace_back(set);
+			set_ids.emplace(hash, static_cast<uint32_t>(sets.size() - 1));
+			return static_cast<uint32_t>(sets.size() - 1);
+		}
+
+		NIHILUS_FORCE_INLINE uint32_t get_transition(uint32_t set_index, uint32_t code_point) {
+			const uint64_t key = (static_cast<uint64_t>(set_index) << 21) | code_point;
+			if (auto iter = transitions.find(key); iter != transitions.end()) {
+				return iter->second;
+			}
+			std::vector<uint32_t> next{};
+			const stack_set set = sets[set_index];
+			for (uint32_t x = 0; x < set.count; ++x) {
+				const uint32_t stack = set_members[set.begin + x];
+				if (stack != 0 && rules.get_char_set(rules.get_element(stack_nodes[stack].element).value).matches(code_point)) {
+					expand(step_stack(stack), next);
+				}
+			}
+			const uint32_t result = intern_set(next);
+			transitions.emplace(key, result);
+			return result;
+		}
+
+		// Feeds one byte; false once the position is dead or the byte is not valid UTF-8 where it stands.
+		NIHILUS_FORCE_INLINE bool advance(parse_state& state, uint8_t byte) {
+			if (state.pending_length == 0) {
+				if (byte < 0x80) {
+					state.set = get_transition(state.set, byte);
+					return state.set != 0;
+				}
+				const uint32_t length = (byte & 0xE0) == 0xC0 ? 1 : (byte & 0xF0) == 0xE0 ? 2 : (byte & 0xF8) == 0xF0 ? 3 : 0;
+				if (length == 0 || !sets[state.set].non_ascii) {
+					return false;
+				}
+				state.pending_length = length;
+				state.pending_value	 = byte & (0x3Fu >> length);
+				return true;
+			}
+			if ((byte & 0xC0) != 0x80) {
+				return false;
+			}
+			state.pending_value = (state.pending_value << 6) | (byte & 0x3Fu);
+			if (--state.pending_length == 0) {
+				state.set			= get_transition(state.set, state.pending_value);
+				state.pending_value = 0;
+				return state.set != 0;
+			}
+			return true;
+		}
+
+		inline void walk_trie(uint32_t node, const parse_state& state, uint64_t* mask) {
+			for (uint32_t child = trie[node].first_child; child != 0; child = trie[child].next_sibling) {
+				parse_state next{ state };
+				if (!advance(next, trie[child].byte)) {
+					continue;
+				}
+				if (next.pending_length == 0 || sets[next.set].non_ascii) {
+					for (uint32_t x = 0; x < trie[child].token_count; ++x) {
+						const uint64_t token = static_cast<uint64_t>(trie_tokens[trie[child].token_begin + x]);
+						mask[token >> 6] |= 1ull << (token & 63);
+					}
+				}
+				walk_trie(child, next, mask);
+			}
+		}
+
+		// Pieces are inserted in sorted order, so every new node is its parent's last child and tokens with equal pieces end on the same node in a row.
+		NIHILUS_FORCE_INLINE void init_trie() {
+			std::vector<int32_t> order{};
+			for (uint64_t x = 0; x < pieces.size(); ++x) {
+				if (!pieces[x].empty() && static_cast<int32_t>(x) != end_token) {
+					order.emplace_back(static_cast<int32_t>(x));
+				}
+			}
+			std::sort(order.begin(), order.end(), [&](int32_t lhs, int32_t rhs) {
+				return pieces[static_cast<uint64_t>(lhs)] < pieces[static_cast<uint64_t>(rhs)];
+			});
+			trie.assign(1, trie_node{});
+			trie_tokens.clear();
+			std::vector<uint32_t> last_child(1, 0);
+			std::vector<uint32_t> path(1, 0);
+			std::string_view previous{};
+			for (const int32_t token: order) {
+				const std::string_view piece = pieces[static_cast<uint64_t>(token)];
+				const uint64_t shared = static_cast<uint64_t>(std::mismatch(piece.begin(), piece.begin() + static_cast<int64_t>(std::min(piece.size(), previous.size())),
+																	 previous.begin())
+																	 .first -
+					piece.begin());
+				path.resize(shared + 1);
+				for (uint64_t x = shared; x < piece.size(); ++x) {
+					const uint32_t node	  = static_cast<uint32_t>(trie.size());
+					const uint32_t parent = path.back();
+					trie.emplace_back(trie_node{ 0, 0, 0, 0, static_cast<uint8_t>(piece[x]) });
+					last_child.emplace_back(0);
+					if (last_child[parent] != 0) {
+						trie[last_child[parent]].next_sibling = node;
+					} else {
+						trie[parent].first_child = node;
+					}
+					last_child[parent] = node;
+					path.emplace_back(node);
+				}
+				trie_node& terminal = trie[path.back()];
+				if (terminal.token_count == 0) {
+					terminal.token_begin = static_cast<uint32_t>(trie_tokens.size());
+				}
+				++terminal.token_count;
+				trie_tokens.emplace_back(token);
+				previous = piece;
+			}
+		}
+	};
+
+	// Grammar text selected on the command line: --grammar-file wins over --json; empty when output is unconstrained.
+	NIHILUS_FORCE_INLINE std::string get_grammar_source(const cli_params& params) {
+		if (!params.grammar_file.empty()) {
+			std::ifstream file{ params.grammar_file, std::ios::binary };
+			if (!file) {
+				log<log_level::error>("grammar: failed to open " + params.grammar_file);
+				return {};
+			}
+			std::stringstream stream{};
+			stream << file.rdbuf();
+			return stream.str();
+		}
+		return params.json_output ? std::string{ json_grammar } : std::string{};
+	}
+
+}
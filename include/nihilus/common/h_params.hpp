@@ -20,6 +20,7 @@ RealTimeChris (Chris M.)
 
 #pragma once
 
+#include <nihilus/common/model_graph_data.hpp>
 #include <nihilus/common/common.hpp>
 #include <iterator>
 
@@ -27,12 +28,60 @@ namespace nihilus {
 
 	template<model_arch> struct hyper_parameters;
 
+	// Shape-invariant parameters taken from the model file at load time; the compile-time model_traits dimensions stay fixed and act as upper bounds.
 	template<> struct hyper_parameters<model_arch::llama> {
 		uint64_t current_sequence_length{};
+		// Positions in the current forward pass; inp_tokens, inp_pos and the kq_mask rows hold [0, batch_token_count) starting at current_sequence_length.
+		uint64_t batch_token_count{ 1 };
+		// Rows gathered by inp_out_ids at the last block, and the rows the final_norm, result_norm and result_output kernels are meant to cover. Those
+		// kernels are still stubs, so nothing restricts them to it yet; today only the token selector reads a row from it.
+		uint64_t output_row_count{ 1 };
 		uint64_t kv_cache_size_per_layer{};
+		uint64_t context_length{};
 		uint64_t batch_size{};
 		uint64_t rope_dims{};
-		double rope_freqs{};
+		double rms_norm_epsilon{ 1e-5 };
+		double rope_freq_base{ 10000.0 };
+		double rope_freq_scale{ 1.0 };
+		double rope_attn_factor{ 1.0 };
+		double rope_ext_factor{};
+		double rope_beta_fast{ 32.0 };
+		double rope_beta_slow{ 1.0 };
+
+		// Values missing from the file keep their defaults. The effective context is the requested length, else the trained length, clamped to the
+		// compiled max_sequence_length.
+		NIHILUS_FORCE_INLINE void set_runtime_parameters(const construction_parameters<model_arch::llama>& cparams, uint64_t requested_context_length,
+			uint64_t max_context_length) {
+			rope_dims = cparams.rope_dimension_count;
+			if (cparams.rms_norm_epsilon > 0.0) {
+				rms_norm_epsilon = cparams.rms_norm_epsilon;
+			}
+			if (cparams.rope_freq_base > 0.0) {
+				rope_freq_base = cparams.rope_freq_base;
+			}
+			// GGUF stores the scaling factor, the kernels want its inverse.
+			if (cparams.rope_freq_scale > 0.0) {
+				rope_freq_scale = 1.0 / cparams.rope_freq_scale;
+			}
+			if (cparams.rope_attn_factor > 0.0) {
+				rope_attn_factor = cparams.rope_attn_factor;
+			}
+			if (cparams.rope_beta_fast > 0.0) {
+				rope_beta_fast = cparams.rope_beta_fast;
+			}
+			if (cparams.rope_beta_slow > 0.0) {
+				rope_beta_slow = cparams.rope_beta_slow;
+			}
+			rope_ext_factor = cparams.rope_ext_factor;
+			context_length	= requested_context_length > 0 ? requested_context_length : cparams.context_length;
+			if (context_length == 0 || context_length > max_context_length) {
+				if (context_length > max_context_length) {
+					log<log_level::status>("hyper_parameters: context length " + std::to_string(context_length) + " exceeds the compiled maximum, clamping to " +
+						std::to_string(max_context_length) + ".");
+				}
+				context_length = max_context_length;
+			}
+		}
 	};
 
 }
@@ -77,7 +77,25 @@ namespace nihilus {
 
 				if (token[0] == '-') {
 					current_flag = token;
-					if (token == "-m" || token == "-t" || token == "-p" || token == "-s" || token == "-n" || token == "-b") {
+					if (token == "--numa") {
+						result.numa = true;
+					} else if (token == "--smt") {
+						result.use_smt = true;
+					} else if (token == "--high-priority") {
+						result.high_priority = true;
+					} else if (token == "--calibrate") {
+						result.calibrate = true;
+					} else if (token == "--repack") {
+						result.repack_weights = true;
+					} else if (token == "--stream-weights") {
+						result.stream_weights = true;
+					} else if (token == "--json") {
+						result.json_output = true;
+					}
+					if (token == "-m" || token == "-t" || token == "-p" || token == "-s" || token == "-n" || token == "-b" || token == "-c" ||
+						token == "--kv-cache-file" || token == "--kv-hot-pages" || token == "--huge-pages" ||
+						token == "--placement" || token == "--cpu-list" || token == "--weight-cache" || token == "--page-in" || token == "--prefetch" ||
+						token == "--mlock" || token == "--token-cache-mb" || token == "--grammar-file") {
 						expect_value = true;
 					} else {
 						expect_value = false;
@@ -111,6 +129,75 @@ namespace nihilus {
 						} catch (const std::exception&) {
 							result.batch_size = 512;
 						}
+					} else if (current_flag == "-c") {
+						try {
+							result.context_length = std::stoull(token);
+						} catch (const std::exception&) {
+							result.context_length = 0;
+						}
+					} else if (current_flag == "--kv-cache-file") {
+						result.kv_cache_file = token;
+					} else if (current_flag == "--kv-hot-pages") {
+						try {
+							result.kv_hot_page_count = std::stoull(token);
+						} catch (const std::exception&) {
+							result.kv_hot_page_count = 64;
+						}
+					} else if (current_flag == "--huge-pages") {
+						if (token == "thp") {
+							result.huge_pages = huge_page_mode::transparent;
+						} else if (token == "2mb") {
+							result.huge_pages = huge_page_mode::huge_2mb;
+						} else if (token == "1gb") {
+							result.huge_pages = huge_page_mode::huge_1gb;
+						} else {
+							result.huge_pages = huge_page_mode::none;
+						}
+					} else if (current_flag == "--placement") {
+						if (token == "cores") {
+							result.placement = thread_placement::cores;
+						} else if (token == "l3") {
+							result.placement = thread_placement::l3;
+						} else {
+							result.placement = thread_placement::none;
+						}
+					} else if (current_flag == "--cpu-list") {
+						result.cpu_list	 = token;
+						result.placement = thread_placement::explicit_list;
+					} else if (current_flag == "--weight-cache") {
+						result.weight_cache_file = token;
+					} else if (current_flag == "--page-in") {
+						if (token == "none") {
+							result.page_in = page_in_mode::none;
+						} else if (token == "advise") {
+							result.page_in = page_in_mode::advise;
+						} else {
+							result.page_in = page_in_mode::touch;
+						}
+					} else if (current_flag == "--prefetch") {
+						if (token == "io_uring") {
+							result.prefetch = prefetch_mode::io_uring;
+						} else if (token == "readahead") {
+							result.prefetch = prefetch_mode::readahead;
+						} else {
+							result.prefetch = prefetch_mode::none;
+						}
+					} else if (current_flag == "--mlock") {
+						if (token == "weights") {
+							result.lock_memory = memory_lock_mode::weights;
+						} else if (token == "all") {
+							result.lock_memory = memory_lock_mode::weights_and_arena;
+						} else {
+							result.lock_memory = memory_lock_mode::none;
+						}
+					} else if (current_flag == "--token-cache-mb") {
+						try {
+							result.token_cache_mb = std::stoull(token);
+						} catch (const std::exception&) {
+							result.token_cache_mb = 64;
+						}
+					} else if (current_flag == "--grammar-file") {
+						result.grammar_file = token;
 					}
 					expect_value = false;
 				}
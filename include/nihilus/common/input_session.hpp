@@ -21,17 +21,23 @@ RealTimeChris (Chris M.)
 #pragma once
 
 #include <nihilus/common/tokenizer.hpp>
+#include <nihilus/common/grammar.hpp>
 #include <nihilus/common/config.hpp>
 #include <iterator>
+#include <vector>
 
 namespace nihilus {
 
 	struct input_session_config {
 		NIHILUS_FORCE_INLINE input_session_config& operator=(const input_session_config&) = delete;
 		NIHILUS_FORCE_INLINE input_session_config(const input_session_config&)			= delete;
-		NIHILUS_FORCE_INLINE input_session_config(std::istream& stream_new, uint64_t max_tokens_new) : stream{ stream_new }, max_tokens{ max_tokens_new } {};
+		NIHILUS_FORCE_INLINE input_session_config(std::istream& stream_new, uint64_t max_tokens_new, std::string_view prompt_new = {}, std::string_view grammar_new = {})
+			: stream{ stream_new }, max_tokens{ max_tokens_new }, prompt{ prompt_new }, grammar{ grammar_new } {};
 		std::istream& stream;
 		uint64_t max_tokens{};
+		std::string_view prompt{};
+		// GBNF source constraining the output (see get_grammar_source); empty for free-form generation.
+		std::string_view grammar{};
 	};
 
 	struct input_session_base {
@@ -46,12 +52,35 @@ namespace nihilus {
 		using base_type = input_session_base;
 
 		NIHILUS_FORCE_INLINE input_session() noexcept = default;
-		NIHILUS_FORCE_INLINE input_session(const input_session_config&, model_type& model) : model_ptr{ &model } {
+		NIHILUS_FORCE_INLINE input_session(const input_session_config& config, model_type& model) : model_ptr{ &model }, input{ config.prompt } {
 			exec_params.thread_count = model.thread_count;
+			this->init(model.get_tokenizer_parameters());
+			this->set_cache(&model.get_tokenization_cache());
+			detokenizer.init(this->max_piece_length());
+			if (!config.grammar.empty()) {
+				init_constraint(config.grammar, model);
+			}
 		};
 
+		// Text of a sampled token, held back while it ends in a partial UTF-8 sequence; valid until the next call.
+		NIHILUS_FORCE_INLINE std::string_view detokenize(int32_t token, bool special = false) noexcept {
+			return detokenizer.push(this->get_piece(token, special));
+		}
+
+		NIHILUS_FORCE_INLINE std::string_view flush_output() noexcept {
+			return detokenizer.flush();
+		}
+
 		NIHILUS_FORCE_INLINE bool process_input() {
-			this->tokenize(input, model_ptr->template get_core<model_type::op_type_type::inp_tokens>().data);
+			input_tokens.clear();
+			this->tokenize(input, input_tokens);
+			exec_params.input_tokens	  = input_tokens.data();
+			exec_params.input_token_count = input_tokens.size();
+			exec_params.position_offset	  = exec_params.kv_cache_seq_len;
+			exec_params.is_prefill		  = true;
+			if (exec_params.constraint) {
+				constraint.reset();
+			}
 			model_ptr->execute_model(exec_params);
 			std::cout << "FOR " << exec_params.thread_count << " THREADS, WITH " << nanosecond_count << " NANOSECONDS OF SPINLOCK PER KERNEL, "
 					  << "NIHILUS AVERAGE COMPUTE TIME, OVER: " << std::setw(50 - std::size("NIHILUS AVERAGE COMPUTE TIME, OVER: ")) << stop_watch_val_nihilus.get_count()
@@ -66,6 +95,20 @@ namespace nihilus {
 	  protected:
 		model_type* model_ptr{};
 		std::string input{};
+		std::vector<int32_t> input_tokens{};
+		incremental_detokenizer detokenizer{};
+		grammar_constraint constraint{};
+
+		NIHILUS_FORCE_INLINE void init_constraint(std::string_view source, model_type& model) {
+			std::vector<std::string_view> pieces(this->vocab_size());
+			for (uint64_t x = 0; x < pieces.size(); ++x) {
+				pieces[x] = this->get_piece(static_cast<int32_t>(x));
+			}
+			using output_core_type = std::remove_cvref_t<decltype(model.template get_core<model_type::op_type_type::result_output>())>;
+			if (constraint.init(source, pieces, static_cast<int32_t>(model.get_tokenizer_parameters().eos_token_id), output_core_type::dims[0])) {
+				exec_params.constraint = &constraint;
+			}
+		}
 	};
 
 }
@@ -22,6 +22,7 @@ RealTimeChris (Chris M.)
 
 #include <nihilus/common/common.hpp>
 #include <nihilus/common/array.hpp>
+#include <nihilus/cpu/topology.hpp>
 #include <latch>
 
 namespace nihilus {
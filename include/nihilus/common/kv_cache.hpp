@@ -0,0 +1,287 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/kernel_type_profile_traits.hpp>
+#include <nihilus/common/model_traits.hpp>
+#include <nihilus/common/allocator.hpp>
+#include <nihilus/common/common.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace nihilus {
+
+	enum class kv_cache_kind : uint8_t {
+		key,
+		value,
+		count,
+	};
+
+	// hot_fetches and cold_fetches count fetch() calls by the tier that answered them; nothing on the pass itself goes through fetch().
+	struct kv_cache_stats {
+		uint64_t bytes_prefetched{};
+		uint64_t bytes_spilled{};
+		uint64_t cold_fetches{};
+		uint64_t hot_fetches{};
+		uint64_t prefetches{};
+		uint64_t spills{};
+	};
+
+	// Two-tier store for kv_cache_strategy::hierarchical - the most recent pages of every layer stay resident in the arena (inside the cache_k/cache_v
+	// allocations), while older pages are written back to a file-backed mapping and read from there directly, with the next layer's range prefetched.
+	// While the tier is active the cache_k/cache_v allocations are a ring of hot pages rather than a positional array, so positions have to be reached
+	// through the page table - page p holds positions p * page_token_count onward. advance() keeps the table current: a page's entries point at its
+	// hot slot when it becomes the newest page and are moved to its cold copy when it is spilled, so a pass never rewrites the whole table.
+	template<model_config config> struct kv_cache_tier {
+		using model_traits_type = model_traits<config.arch, config.model_size, config.model_generation>;
+		using kv_cache_type		= typename kernel_type_profile_traits<config.kernel_profile>::kv_cache_type;
+		static constexpr uint64_t page_token_count{ config.kv_cache_block_size > 0 ? config.kv_cache_block_size : 16 };
+		static constexpr uint64_t page_element_count{ page_token_count * model_traits_type::head_count_kv * model_traits_type::head_dim };
+		static constexpr uint64_t page_bytes{ round_up_to_multiple(page_element_count * sizeof(kv_cache_type), cpu_alignment) };
+		static constexpr uint64_t kind_count{ static_cast<uint64_t>(kv_cache_kind::count) };
+
+		NIHILUS_FORCE_INLINE kv_cache_tier() noexcept							 = default;
+		NIHILUS_FORCE_INLINE kv_cache_tier& operator=(const kv_cache_tier&) = delete;
+		NIHILUS_FORCE_INLINE kv_cache_tier(const kv_cache_tier&)			 = delete;
+
+		// Pages a batch of token_count positions can span when it starts anywhere inside a page.
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_batch_page_count(uint64_t token_count) noexcept {
+			return token_count > 0 ? (token_count + page_token_count - 2) / page_token_count + 1 : 0;
+		}
+
+		// Every page a pass writes has to be hot at once - advance() spills the oldest hot page for each new one, so a batch spanning more pages than
+		// the hot tier holds would spill the front of the batch before its rows are written. batch_token_count raises the hot page count to cover it.
+		NIHILUS_FORCE_INLINE bool init(std::string_view backing_path, uint64_t context_length, uint64_t hot_page_count_new, uint64_t batch_token_count,
+			uint64_t hot_capacity_bytes, const array<array<void*, model_traits_type::block_count>, kind_count>& hot_storage_new) {
+			page_count						 = (context_length + page_token_count - 1) / page_token_count;
+			const uint64_t batch_pages		 = std::min(get_batch_page_count(batch_token_count), page_count);
+			const uint64_t hot_page_capacity = std::min(hot_capacity_bytes / page_bytes, page_count);
+			if (hot_page_count_new < batch_pages) {
+				log<log_level::status>("kv_cache_tier: raising the hot tier from " + std::to_string(hot_page_count_new) + " to " + std::to_string(batch_pages) +
+					" pages to cover a " + std::to_string(batch_token_count) + " token batch.");
+				hot_page_count_new = batch_pages;
+			}
+			hot_page_count = std::min(hot_page_count_new, hot_page_capacity);
+			if (hot_page_count == 0 || page_count == 0 || hot_page_count < batch_pages) {
+				log<log_level::error>("kv_cache_tier: the hot tier cannot hold a full batch, falling back to the resident cache.");
+				return false;
+			}
+			hot_storage	   = hot_storage_new;
+			newest_page	   = 0;
+			cold_size	   = model_traits_type::block_count * kind_count * page_count * page_bytes;
+			backing_path_  = backing_path;
+			if (!map_cold_tier()) {
+				return false;
+			}
+			page_table.assign(kind_count * model_traits_type::block_count * page_count, nullptr);
+			prefetched_pages = {};
+			publish_page(0, true);
+			log<log_level::status>("kv_cache_tier: " + std::to_string(hot_page_count) + " hot pages per layer, " + std::to_string(page_count) + " total pages of " +
+				std::to_string(page_bytes) + " bytes, cold tier " + std::to_string(cold_size / (1024ull * 1024ull)) + " MB at " +
+				(backing_path_.empty() ? std::string{ "<anonymous>" } : backing_path_));
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return cold_data != nullptr;
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t first_hot_page() const noexcept {
+			return newest_page + 1 > hot_page_count ? newest_page + 1 - hot_page_count : 0;
+		}
+
+		// Called by the main thread before a token at position sequence_length is computed - pages that roll out of the hot window are written back.
+		NIHILUS_FORCE_INLINE void advance(uint64_t sequence_length) {
+			const uint64_t target_page = std::min(sequence_length / page_token_count, page_count - 1);
+			while (newest_page < target_page) {
+				const uint64_t evicted_page = first_hot_page();
+				if (newest_page + 1 >= hot_page_count) {
+					spill_page(evicted_page);
+					publish_page(evicted_page, false);
+				}
+				++newest_page;
+				publish_page(newest_page, true);
+			}
+		}
+
+		NIHILUS_FORCE_INLINE kv_cache_type* fetch(uint64_t block, kv_cache_kind kind, uint64_t page) noexcept {
+			if NIHILUS_LIKELY (page >= first_hot_page()) {
+				hot_fetches.fetch_add(1, std::memory_order_relaxed);
+			} else {
+				cold_fetches.fetch_add(1, std::memory_order_relaxed);
+			}
+			return get_page_table(block, kind)[page];
+		}
+
+		// Largest batch that stays inside the hot tier from any starting position.
+		NIHILUS_FORCE_INLINE uint64_t get_batch_capacity() const noexcept {
+			return (hot_page_count - 1) * page_token_count + 1;
+		}
+
+		NIHILUS_FORCE_INLINE kv_cache_type* const* get_page_table(uint64_t block, kv_cache_kind kind) const noexcept {
+			return page_table.data() + (static_cast<uint64_t>(kind) * model_traits_type::block_count + block) * page_count;
+		}
+
+		// Advises only the cold pages of block spilled since its last call: a pass reads the whole cold range, and everything before the cursor has
+		// already been advised once.
+		NIHILUS_FORCE_INLINE void prefetch(uint64_t block) noexcept {
+			if (block >= model_traits_type::block_count) {
+				return;
+			}
+			const uint64_t first_page = prefetched_pages[block];
+			const uint64_t last_page  = first_hot_page();
+			if (last_page <= first_page) {
+				return;
+			}
+			for (uint64_t x = 0; x < kind_count; ++x) {
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+				posix_madvise(cold_page_ptr(block, static_cast<kv_cache_kind>(x), first_page), (last_page - first_page) * page_bytes, POSIX_MADV_WILLNEED);
+#endif
+			}
+			prefetched_pages[block] = last_page;
+			prefetches.fetch_add(1, std::memory_order_relaxed);
+			bytes_prefetched.fetch_add((last_page - first_page) * page_bytes * kind_count, std::memory_order_relaxed);
+		}
+
+		NIHILUS_FORCE_INLINE kv_cache_stats get_stats() const noexcept {
+			kv_cache_stats return_value{};
+			return_value.bytes_prefetched = bytes_prefetched.load(std::memory_order_relaxed);
+			return_value.bytes_spilled	  = bytes_spilled.load(std::memory_order_relaxed);
+			return_value.cold_fetches	  = cold_fetches.load(std::memory_order_relaxed);
+			return_value.hot_fetches	  = hot_fetches.load(std::memory_order_relaxed);
+			return_value.prefetches		  = prefetches.load(std::memory_order_relaxed);
+			return_value.spills			  = spills.load(std::memory_order_relaxed);
+			return return_value;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() const {
+			kv_cache_stats stats{ get_stats() };
+			log<log_level::status>("kv_cache_tier: fetches: " + std::to_string(stats.hot_fetches) + " hot, " + std::to_string(stats.cold_fetches) + " cold, spills: " +
+				std::to_string(stats.spills) + " (" + std::to_string(stats.bytes_spilled) + " bytes), prefetches: " + std::to_string(stats.prefetches) + " (" +
+				std::to_string(stats.bytes_prefetched) + " bytes)");
+		}
+
+		NIHILUS_FORCE_INLINE ~kv_cache_tier() {
+			unmap_cold_tier();
+		}
+
+	  protected:
+		array<array<void*, model_traits_type::block_count>, kind_count> hot_storage{};
+		array<uint64_t, model_traits_type::block_count> prefetched_pages{};
+		std::vector<kv_cache_type*> page_table{};
+		std::atomic<uint64_t> bytes_prefetched{};
+		std::atomic<uint64_t> bytes_spilled{};
+		std::atomic<uint64_t> cold_fetches{};
+		std::atomic<uint64_t> hot_fetches{};
+		std::atomic<uint64_t> prefetches{};
+		std::atomic<uint64_t> spills{};
+		std::string backing_path_{};
+		uint64_t hot_page_count{};
+		uint8_t* cold_data{};
+		uint64_t newest_page{};
+		uint64_t page_count{};
+		uint64_t cold_size{};
+		int file_descriptor{ -1 };
+
+		NIHILUS_FORCE_INLINE uint8_t* hot_page_ptr(uint64_t block, kv_cache_kind kind, uint64_t page) const noexcept {
+			return static_cast<uint8_t*>(hot_storage[static_cast<uint64_t>(kind)][block]) + (page % hot_page_count) * page_bytes;
+		}
+
+		NIHILUS_FORCE_INLINE uint8_t* cold_page_ptr(uint64_t block, kv_cache_kind kind, uint64_t page) const noexcept {
+			return cold_data + ((block * kind_count + static_cast<uint64_t>(kind)) * page_count + page) * page_bytes;
+		}
+
+		NIHILUS_FORCE_INLINE void publish_page(uint64_t page, bool hot) noexcept {
+			for (uint64_t x = 0; x < kind_count; ++x) {
+				for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+					uint8_t* data = hot ? hot_page_ptr(y, static_cast<kv_cache_kind>(x), page) : cold_page_ptr(y, static_cast<kv_cache_kind>(x), page);
+					page_table[(x * model_traits_type::block_count + y) * page_count + page] = reinterpret_cast<kv_cache_type*>(data);
+				}
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void spill_page(uint64_t page) noexcept {
+			for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
+				for (uint64_t y = 0; y < kind_count; ++y) {
+					std::memcpy(cold_page_ptr(x, static_cast<kv_cache_kind>(y), page), hot_page_ptr(x, static_cast<kv_cache_kind>(y), page), page_bytes);
+				}
+			}
+			spills.fetch_add(1, std::memory_order_relaxed);
+			bytes_spilled.fetch_add(page_bytes * model_traits_type::block_count * kind_count, std::memory_order_relaxed);
+		}
+
+		NIHILUS_FORCE_INLINE bool map_cold_tier() {
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+			log<log_level::error>("kv_cache_tier: file-backed cold tier is not supported on this platform.");
+			return false;
+#else
+			void* result{};
+			if (backing_path_.empty()) {
+				result = mmap(nullptr, cold_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			} else {
+				file_descriptor = open(backing_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+				if (file_descriptor == -1) {
+					log<log_level::error>("kv_cache_tier: failed to open backing file " + backing_path_ + ": " + std::string{ std::strerror(errno) });
+					return false;
+				}
+				if (ftruncate(file_descriptor, static_cast<off_t>(cold_size)) != 0) {
+					log<log_level::error>("kv_cache_tier: failed to size backing file: " + std::string{ std::strerror(errno) });
+					close(file_descriptor);
+					file_descriptor = -1;
+					return false;
+				}
+				result = mmap(nullptr, cold_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+			}
+			if (result == MAP_FAILED) {
+				log<log_level::error>("kv_cache_tier: failed to map the cold tier: " + std::string{ std::strerror(errno) });
+				if (file_descriptor != -1) {
+					close(file_descriptor);
+					file_descriptor = -1;
+				}
+				return false;
+			}
+			cold_data = static_cast<uint8_t*>(result);
+			return true;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE void unmap_cold_tier() noexcept {
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+			if (cold_data) {
+				munmap(cold_data, cold_size);
+				cold_data = nullptr;
+			}
+			if (file_descriptor != -1) {
+				close(file_descriptor);
+				file_descriptor = -1;
+			}
+#endif
+		}
+	};
+
+}
@@ -25,9 +25,274 @@ RealTimeChris (Chris M.)
 #include <nihilus/common/config.hpp>
 #include <stdexcept>
 #include <iterator>
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <cerrno>
+
+#if defined(NIHILUS_PLATFORM_LINUX)
+	#include <sys/resource.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
 
 namespace nihilus {
 
+	static constexpr uint64_t huge_page_size_2mb{ 2ull * 1024ull * 1024ull };
+	static constexpr uint64_t huge_page_size_1gb{ 1024ull * 1024ull * 1024ull };
+
+	NIHILUS_FORCE_INLINE constexpr const char* get_huge_page_mode_name(huge_page_mode mode) {
+		switch (mode) {
+			case huge_page_mode::transparent: {
+				return "transparent huge pages";
+			}
+			case huge_page_mode::huge_2mb: {
+				return "2 MB huge pages";
+			}
+			case huge_page_mode::huge_1gb: {
+				return "1 GB huge pages";
+			}
+			default: {
+				return "4 KB pages";
+			}
+		}
+	}
+
+	// Reports the anonymous and file-backed bytes the kernel actually placed on huge pages for this process.
+	NIHILUS_FORCE_INLINE void log_huge_page_usage() {
+#if defined(NIHILUS_PLATFORM_LINUX)
+		std::ifstream smaps{ "/proc/self/smaps_rollup" };
+		std::string line{};
+		std::string summary{};
+		while (std::getline(smaps, line)) {
+			if (line.starts_with("AnonHugePages:") || line.starts_with("FilePmdMapped:") || line.starts_with("Private_Hugetlb:") || line.starts_with("Shared_Hugetlb:")) {
+				summary += (summary.empty() ? "" : ", ") + line.substr(0, line.find(':') + 1) + " " + line.substr(line.find_first_not_of(' ', line.find(':') + 1));
+			}
+		}
+		if (!summary.empty()) {
+			log<log_level::status>("Huge page usage: " + summary);
+		}
+#endif
+	}
+
+	// advise only queues readahead for the range; touch also reads one byte per page so the faults are taken here rather than by the first token.
+	NIHILUS_FORCE_INLINE uint64_t page_in_range(const void* data, uint64_t size, page_in_mode mode) noexcept {
+		static constexpr uint64_t page_size{ 4096 };
+		if (mode == page_in_mode::none || !data || size == 0) {
+			return 0;
+		}
+#if defined(NIHILUS_PLATFORM_LINUX)
+		const uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+		posix_madvise(reinterpret_cast<void*>(first), reinterpret_cast<uintptr_t>(data) + size - first, POSIX_MADV_WILLNEED);
+#endif
+		uint64_t checksum{};
+		if (mode == page_in_mode::touch) {
+			const volatile uint8_t* bytes = static_cast<const volatile uint8_t*>(data);
+			for (uint64_t x = 0; x < size; x += page_size) {
+				checksum += bytes[x];
+			}
+			checksum += bytes[size - 1];
+		}
+		return checksum;
+	}
+
+	// Bytes of [data, data + size) already in memory, counted per page with mincore(2).
+	NIHILUS_FORCE_INLINE uint64_t get_resident_bytes(const void* data, uint64_t size) {
+#if defined(NIHILUS_PLATFORM_LINUX)
+		static const uint64_t page_size{ static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) };
+		if (!data || size == 0) {
+			return 0;
+		}
+		const uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+		const uintptr_t last  = round_up_to_multiple(reinterpret_cast<uintptr_t>(data) + size, page_size);
+		std::vector<unsigned char> pages((last - first) / page_size);
+		if (mincore(reinterpret_cast<void*>(first), last - first, pages.data()) != 0) {
+			return 0;
+		}
+		uint64_t resident_pages{};
+		for (unsigned char page: pages) {
+			resident_pages += page & 1;
+		}
+		return resident_pages * page_size;
+#else
+		( void )data;
+		( void )size;
+		return 0;
+#endif
+	}
+
+	NIHILUS_FORCE_INLINE constexpr const char* get_memory_lock_mode_name(memory_lock_mode mode) {
+		switch (mode) {
+			case memory_lock_mode::weights: {
+				return "weights";
+			}
+			case memory_lock_mode::weights_and_arena: {
+				return "weights and arena";
+			}
+			default: {
+				return "none";
+			}
+		}
+	}
+
+	struct memory_lock_stats {
+		uint64_t bytes_requested{};
+		uint64_t bytes_locked{};
+		uint64_t bytes_skipped{};
+		uint64_t limit_bytes{};
+		uint64_t physical_bytes{};
+		uint64_t budget_bytes{};
+		uint64_t locked_chunks{};
+		uint64_t failed_chunks{};
+		int last_error{};
+		bool capped{};
+	};
+
+	// mlock()s ranges in fixed-size chunks after raising the RLIMIT_MEMLOCK soft limit to the hard limit. When the limit runs out the remaining budget
+	// is still locked and every later range is skipped, so a small limit pins the ranges passed first instead of nothing; callers lock the ranges they
+	// least want paged out first. The total is also capped below physical RAM, since locking more than the machine has (a root run over the whole
+	// arena) only pushes the rest of the system into swap or the OOM killer. Locks are released on destruction, so the locker must be
+	// destroyed before the memory it locked is freed.
+	struct memory_locker {
+		static constexpr uint64_t chunk_bytes{ 64ull * 1024ull * 1024ull };
+		static constexpr uint64_t reserved_bytes{ 2ull * 1024ull * 1024ull * 1024ull };
+
+		NIHILUS_FORCE_INLINE memory_locker() noexcept = default;
+
+		NIHILUS_FORCE_INLINE memory_locker& operator=(const memory_locker&) = delete;
+		NIHILUS_FORCE_INLINE memory_locker(const memory_locker&)			= delete;
+
+		NIHILUS_FORCE_INLINE void init() noexcept {
+			unlock_all();
+			stats	  = memory_lock_stats{};
+			exhausted = false;
+#if defined(NIHILUS_PLATFORM_LINUX)
+			page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+			rlimit limit{};
+			if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0) {
+				if (limit.rlim_cur != limit.rlim_max) {
+					rlimit raised{ limit.rlim_max, limit.rlim_max };
+					if (setrlimit(RLIMIT_MEMLOCK, &raised) == 0) {
+						limit = raised;
+					}
+				}
+				stats.limit_bytes = limit.rlim_cur == RLIM_INFINITY ? std::numeric_limits<uint64_t>::max() : static_cast<uint64_t>(limit.rlim_cur);
+			}
+			const long physical_pages = sysconf(_SC_PHYS_PAGES);
+			stats.physical_bytes	  = physical_pages > 0 ? static_cast<uint64_t>(physical_pages) * page_size : std::numeric_limits<uint64_t>::max();
+			// Leave an eighth of RAM, and at least reserved_bytes, unlocked for the kernel, the page cache and everything else on the machine.
+			const uint64_t headroom = std::max(stats.physical_bytes / 8, reserved_bytes);
+			stats.budget_bytes		= stats.physical_bytes > headroom ? stats.physical_bytes - headroom : 0;
+#endif
+		}
+
+		// Returns the number of bytes of [data, data + size) that are now locked.
+		NIHILUS_FORCE_INLINE uint64_t lock(const void* data, uint64_t size) noexcept {
+			if (!data || size == 0) {
+				return 0;
+			}
+#if defined(NIHILUS_PLATFORM_LINUX)
+			const uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+			const uintptr_t last  = round_up_to_multiple(reinterpret_cast<uintptr_t>(data) + size, page_size);
+			stats.bytes_requested += last - first;
+			uint64_t locked_bytes{};
+			for (uintptr_t x = first; x < last; x += chunk_bytes) {
+				const uint64_t length = std::min<uint64_t>(chunk_bytes, last - x);
+				if (exhausted) {
+					stats.bytes_skipped += length;
+					continue;
+				}
+				const bool fits = within_budget(length);
+				if (fits && lock_chunk(x, length)) {
+					locked_bytes += length;
+					continue;
+				}
+				// Locked memory is charged per page against the limit, so whatever budget is left can still hold the front of this chunk.
+				const uint64_t budget	 = fits ? stats.limit_bytes : stats.budget_bytes;
+				const uint64_t remaining = budget > stats.bytes_locked ? (budget - stats.bytes_locked) & ~(page_size - 1) : 0;
+				if (remaining > 0 && remaining < length && lock_chunk(x, remaining)) {
+					locked_bytes += remaining;
+					stats.bytes_skipped += length - remaining;
+				} else {
+					stats.bytes_skipped += length;
+				}
+				exhausted = true;
+			}
+			return locked_bytes;
+#else
+			stats.bytes_requested += size;
+			stats.bytes_skipped += size;
+			return 0;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE const memory_lock_stats& get_stats() const noexcept {
+			return stats;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() const {
+			static constexpr uint64_t megabyte{ 1024ull * 1024ull };
+			const std::string limit{ stats.limit_bytes == std::numeric_limits<uint64_t>::max() ? "unlimited" : std::to_string(stats.limit_bytes / megabyte) + " MB" };
+			log<log_level::status>("memory_locker: locked " + std::to_string(stats.bytes_locked / megabyte) + " MB of " + std::to_string(stats.bytes_requested / megabyte) +
+				" MB requested in " + std::to_string(stats.locked_chunks) + " chunks (RLIMIT_MEMLOCK " + limit + ").");
+			if (stats.capped) {
+				log<log_level::status>("memory_locker: capped at " + std::to_string(stats.budget_bytes / megabyte) + " MB of " +
+					std::to_string(stats.physical_bytes / megabyte) + " MB physical RAM, " + std::to_string(stats.bytes_skipped / megabyte) + " MB left pageable.");
+			}
+			if (stats.failed_chunks > 0) {
+				log<log_level::error>("memory_locker: mlock failed (" + std::string{ std::strerror(stats.last_error) } + "), " +
+					std::to_string(stats.bytes_skipped / megabyte) + " MB left pageable; raise the limit with ulimit -l or grant CAP_IPC_LOCK to lock everything.");
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void unlock_all() noexcept {
+#if defined(NIHILUS_PLATFORM_LINUX)
+			for (const auto& [address, length]: locked_ranges) {
+				munlock(reinterpret_cast<void*>(address), length);
+			}
+#endif
+			locked_ranges.clear();
+		}
+
+		NIHILUS_FORCE_INLINE ~memory_locker() noexcept {
+			unlock_all();
+		}
+
+	  protected:
+		std::vector<std::pair<uintptr_t, uint64_t>> locked_ranges{};
+		memory_lock_stats stats{};
+		uint64_t page_size{ 4096 };
+		bool exhausted{};
+
+		// The RAM cap is checked here rather than left to mlock, since CAP_IPC_LOCK lifts RLIMIT_MEMLOCK but nothing stops root locking past RAM.
+		NIHILUS_FORCE_INLINE bool within_budget(uint64_t length) noexcept {
+			if (stats.bytes_locked + length <= stats.budget_bytes) {
+				return true;
+			}
+			stats.capped = true;
+			return false;
+		}
+
+		NIHILUS_FORCE_INLINE bool lock_chunk(uintptr_t address, uint64_t length) noexcept {
+#if defined(NIHILUS_PLATFORM_LINUX)
+			if (mlock(reinterpret_cast<const void*>(address), length) != 0) {
+				stats.last_error = errno;
+				++stats.failed_chunks;
+				return false;
+			}
+			locked_ranges.emplace_back(address, length);
+			stats.bytes_locked += length;
+			++stats.locked_chunks;
+			return true;
+#else
+			( void )address;
+			( void )length;
+			return false;
+#endif
+		}
+	};
+
 	template<model_config config> struct memory_buffer : public allocator<uint8_t> {
 		using value_type = uint8_t;
 		using alloc		 = allocator<value_type>;
@@ -42,6 +307,8 @@ namespace nihilus {
 		NIHILUS_FORCE_INLINE memory_buffer& operator=(memory_buffer&& other) noexcept {
 			if (this != &other) {
 				std::swap(current_offset, other.current_offset);
+				std::swap(allocation_mode, other.allocation_mode);
+				std::swap(mapped_size, other.mapped_size);
 				std::swap(data_val, other.data_val);
 				std::swap(size_val, other.size_val);
 			}
@@ -52,14 +319,27 @@ namespace nihilus {
 			*this = std::move(other);
 		}
 
-		NIHILUS_FORCE_INLINE void init(uint64_t size) noexcept {
+		NIHILUS_FORCE_INLINE void init(uint64_t size, huge_page_mode mode = huge_page_mode::none) noexcept {
 			if (data_val) {
 				clear();
 			}
-			data_val = alloc::allocate(size);
+			current_offset = 0;
+			if (mode != huge_page_mode::none) {
+				data_val = allocate_huge(size, mode);
+				log<log_level::status>("memory_buffer: " + std::to_string(size / (1024ull * 1024ull)) + " MB requested with " + get_huge_page_mode_name(mode) +
+					", backed by " + get_huge_page_mode_name(allocation_mode));
+			}
+			if (!data_val) {
+				allocation_mode = huge_page_mode::none;
+				data_val		= alloc::allocate(size);
+			}
 			size_val = size;
 		}
 
+		NIHILUS_FORCE_INLINE huge_page_mode get_allocation_mode() const noexcept {
+			return allocation_mode;
+		}
+
 		NIHILUS_FORCE_INLINE void deinit() noexcept {
 			clear();
 		}
@@ -95,15 +375,92 @@ namespace nihilus {
 		}
 
 	  protected:
+		huge_page_mode allocation_mode{};
 		size_type current_offset{};
+		size_type mapped_size{};
 		value_type* data_val{};
 		size_type size_val{};
 
+		NIHILUS_FORCE_INLINE pointer map_anonymous(uint64_t size, [[maybe_unused]] int extra_flags) noexcept {
+#if defined(NIHILUS_PLATFORM_LINUX)
+			void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+			if (result == MAP_FAILED) {
+				return nullptr;
+			}
+			mapped_size = size;
+			return static_cast<pointer>(result);
+#else
+			return nullptr;
+#endif
+		}
+
+		// Tries the requested page size first and degrades 1 GB -> 2 MB -> transparent huge pages, returning nullptr only when none of them are available.
+		// The page size is encoded as log2 << MAP_HUGE_SHIFT because glibc's <sys/mman.h> only exposes the shift, not MAP_HUGE_2MB/MAP_HUGE_1GB.
+		NIHILUS_FORCE_INLINE pointer allocate_huge(uint64_t size, huge_page_mode mode) noexcept {
+#if defined(NIHILUS_PLATFORM_LINUX)
+			pointer return_value{};
+	#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+			if (mode == huge_page_mode::huge_1gb) {
+				if ((return_value = map_anonymous(round_up_to_multiple(size, huge_page_size_1gb), MAP_HUGETLB | (30 << MAP_HUGE_SHIFT))) != nullptr) {
+					allocation_mode = huge_page_mode::huge_1gb;
+					return return_value;
+				}
+				mode = huge_page_mode::huge_2mb;
+			}
+	#endif
+	#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+			if (mode == huge_page_mode::huge_2mb) {
+				if ((return_value = map_anonymous(round_up_to_multiple(size, huge_page_size_2mb), MAP_HUGETLB | (21 << MAP_HUGE_SHIFT))) != nullptr) {
+					allocation_mode = huge_page_mode::huge_2mb;
+					return return_value;
+				}
+			}
+	#endif
+	#if defined(MADV_HUGEPAGE)
+			const uint64_t aligned_size = round_up_to_multiple(size, huge_page_size_2mb);
+			pointer raw					= map_anonymous(aligned_size + huge_page_size_2mb, 0);
+			if (!raw) {
+				return nullptr;
+			}
+			const uint64_t head = round_up_to_multiple(reinterpret_cast<uintptr_t>(raw), huge_page_size_2mb) - reinterpret_cast<uintptr_t>(raw);
+			if (head > 0) {
+				munmap(raw, head);
+			}
+			if (huge_page_size_2mb - head > 0) {
+				munmap(raw + head + aligned_size, huge_page_size_2mb - head);
+			}
+			return_value = raw + head;
+			mapped_size	 = aligned_size;
+			if (madvise(return_value, aligned_size, MADV_HUGEPAGE) == 0) {
+				allocation_mode = huge_page_mode::transparent;
+			} else {
+				allocation_mode = huge_page_mode::none;
+			}
+			return return_value;
+	#else
+			return nullptr;
+	#endif
+#else
+			( void )size;
+			( void )mode;
+			return nullptr;
+#endif
+		}
+
 		NIHILUS_FORCE_INLINE void clear() noexcept {
 			if (data_val) {
+#if defined(NIHILUS_PLATFORM_LINUX)
+				if (mapped_size > 0) {
+					munmap(data_val, mapped_size);
+				} else {
+					alloc::deallocate(data_val);
+				}
+#else
 				alloc::deallocate(data_val);
-				data_val = nullptr;
-				size_val = 0;
+#endif
+				data_val	= nullptr;
+				size_val	= 0;
+				mapped_size = 0;
 			}
 		}
 	};
@@ -23,6 +23,12 @@ RealTimeChris (Chris M.)
 #include <nihilus/common/arch_traits.hpp>
 #include <nihilus/common/model_traits.hpp>
 #include <nihilus/common/model_parser.hpp>
+#include <nihilus/common/weight_streamer.hpp>
+#include <nihilus/common/file_prefetcher.hpp>
+#include <nihilus/common/weight_cache.hpp>
+#include <nihilus/common/tokenizer.hpp>
+#include <nihilus/common/grammar.hpp>
+#include <nihilus/common/kv_cache.hpp>
 #include <nihilus/cpu/thread_pool.hpp>
 #include <nihilus/common/h_params.hpp>
 #include <nihilus/common/tuple.hpp>
@@ -55,15 +61,57 @@ namespace nihilus {
 		NIHILUS_FORCE_INLINE model(model&&)				  = delete;
 		NIHILUS_FORCE_INLINE model& operator=(const model&) = delete;
 		NIHILUS_FORCE_INLINE model(const model&)			  = delete;
-		NIHILUS_FORCE_INLINE model(cli_params params) : thread_pool<config, model>{ params.thread_count } {
+		NIHILUS_FORCE_INLINE model(cli_params params) : thread_pool<config, model>{ params } {
 			stop_watch_val_nihilus.reset();
-			memory.init(total_required_bytes);
-			model_data.init(params.model_file);
+			memory.init(total_required_bytes, params.huge_pages);
+			model_data.init(params.model_file, 0, this->numa.is_active(), params.huge_pages != huge_page_mode::none);
 			//if constexpr ()
 			array<array<void*, model_traits_type::block_count>, op_type_type::count> data{};
 			core_bases_config_type::template impl<memory_mapper>(memory);
 			core_bases_config_type::template impl<execution_planner>(params.thread_count, data);
-			model_graph_data<config> model_construction_data = model_parser<config>::parse_model(params.model_file, data, model_data);
+			model_graph_data<config> model_construction_data{};
+			// Opt-in until a mul_mat kernel reads the interleaved layout. Streamed blocks are read straight from the file, so they cannot use it.
+			const uint64_t packed_rows = params.repack_weights && !params.stream_weights ? packed_q8_0_layout::rows_per_group : 0;
+			if (params.weight_cache_file.empty() || !cache.load(params.weight_cache_file, params.model_file, model_data, data, model_construction_data, packed_rows)) {
+				model_construction_data = model_parser<config>::parse_model(params.model_file, data, model_data);
+				if (packed_rows > 0) {
+					repack_weights(params);
+				}
+				if (!params.weight_cache_file.empty()) {
+					cache.save(params.weight_cache_file, params.model_file, model_data, data, model_construction_data, packed_weights.data(), packed_weights_size,
+						packed_rows);
+				}
+			}
+			tokenizer_params = model_construction_data.tokenizer_params.tokens.empty() ? model_parser<config>::parse_tokenizer(model_data)
+																					   : std::move(model_construction_data.tokenizer_params);
+			token_cache.init(params.token_cache_mb * 1024ull * 1024ull);
+			get_core<op_type_type::result_output>().selector.init(params.thread_count, core_traits<config, op_type_type::result_output>::dims[0]);
+			this->set_runtime_parameters(model_construction_data.cparams, params.context_length, model_traits_type::max_sequence_length);
+			this->batch_size = std::min<uint64_t>(params.batch_size, model_traits_type::max_batch_size);
+			if (params.batch_size > model_traits_type::max_batch_size) {
+				log<log_level::status>("Batch size " + std::to_string(params.batch_size) + " exceeds the compiled maximum, using " + std::to_string(this->batch_size) + ".");
+			}
+			if constexpr (config.cache_strategy == kv_cache_strategy::hierarchical) {
+				init_kv_cache(params);
+			}
+			if (this->numa.is_active()) {
+				place_weights_on_nodes(packed_rows > 0);
+			}
+			if (params.stream_weights) {
+				init_weight_streamer(params);
+			}
+			if (params.prefetch != prefetch_mode::none && !streamer.is_active()) {
+				init_file_prefetcher(params, packed_rows > 0);
+			}
+			if (params.page_in != page_in_mode::none) {
+				page_in_weights(params.page_in, packed_rows > 0);
+			}
+			if (params.lock_memory != memory_lock_mode::none) {
+				lock_memory(params.lock_memory, packed_rows > 0);
+			}
+			if (params.huge_pages != huge_page_mode::none) {
+				log_huge_page_usage();
+			}
 			std::cout << "TIME TO LOAD MODEL: " << stop_watch_val_nihilus.total_time_elapsed() << std::endl;
 		}
 
@@ -73,6 +121,7 @@ namespace nihilus {
 		}
 
 		NIHILUS_FORCE_INLINE void deinit(cli_params params) {
+			locker.unlock_all();
 			model_data.deinit();
 			memory.deinit();
 		}
@@ -81,11 +130,95 @@ namespace nihilus {
 			return *static_cast<core_traits<config, type>*>(this);
 		}
 
+		NIHILUS_FORCE_INLINE const tokenizer_parameters<config.arch>& get_tokenizer_parameters() const noexcept {
+			return tokenizer_params;
+		}
+
+		// Tokens picked by the last execute_model call.
+		NIHILUS_FORCE_INLINE const std::vector<int32_t>& get_generated_tokens() const noexcept {
+			return generated_tokens;
+		}
+
+		NIHILUS_FORCE_INLINE tokenization_cache& get_tokenization_cache() noexcept {
+			return token_cache;
+		}
+
+		NIHILUS_FORCE_INLINE kv_cache_tier<config>& get_kv_cache() {
+			return kv_cache;
+		}
+
+		NIHILUS_FORCE_INLINE void on_block_main(uint64_t current_block) {
+			if constexpr (config.cache_strategy == kv_cache_strategy::hierarchical) {
+				if (kv_cache.is_active()) {
+					kv_cache.prefetch(current_block + 1);
+				}
+			}
+			if (streamer.is_active()) {
+				streamer.enter_block(this->thread_count);
+			}
+			if (prefetcher.is_active()) {
+				prefetch_step((current_block + prefetch_distance) % prefetch_ranges.size());
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void on_block_worker(uint64_t thread_index, uint64_t) {
+			if (streamer.is_active()) {
+				streamer.enter_block(thread_index);
+			}
+		}
+
 		NIHILUS_FORCE_INLINE void execute_model(execution_parameters& params) {
-			for (size_t x = 0; x < params.token_count + 1; ++x) {
-				stop_watch_val_nihilus.reset();
-				this->execute_tasks();
-				stop_watch_val_nihilus.add_time();
+			// A prefill runs the prompt in batch_size-token chunks (one token per pass otherwise) and only the last row of the last chunk is sampled;
+			// decode steps then feed each picked token back one position at a time. Bounding the chunk keeps any one pass - and so the gap before the
+			// next decode step - from scaling with the prompt. The token picked last is not in the KV cache yet, so a follow-up prompt carries it at the
+			// head of its first chunk instead of spending a single-token pass on it. The next token is picked inside the result_output phase (argmax
+			// when the temperature is non-positive, sampled otherwise). Under a grammar constraint the row is masked in the same phase and generation
+			// stops at the end token or a dead end. A call without input tokens continues from the pending token and is rejected when there is none.
+			generated_tokens.clear();
+			if (params.clear_kv_cache) {
+				this->current_sequence_length = 0;
+				pending_token				  = -1;
+			} else if (params.is_prefill && params.position_offset != this->current_sequence_length) {
+				this->current_sequence_length = params.position_offset;
+				pending_token				  = -1;
+			}
+			const uint64_t prompt = params.input_tokens ? params.input_token_count : 0;
+			if (prompt == 0 && pending_token < 0) {
+				log<log_level::error>("execute_model: no input tokens and no sampled token to continue from.");
+				params.kv_cache_seq_len = this->current_sequence_length;
+				return;
+			}
+			first_pass			 = true;
+			int32_t token		 = pending_token;
+			const uint64_t chunk = params.is_prefill ? get_prefill_chunk_size(params) : 1;
+			bool running		 = true;
+			uint64_t x			 = 0;
+			if (pending_token >= 0 && prompt > 0) {
+				const uint64_t count = std::min(chunk - 1, prompt);
+				chunk_tokens.assign(1, pending_token);
+				chunk_tokens.insert(chunk_tokens.end(), params.input_tokens, params.input_tokens + count);
+				running = run_batch(params, chunk_tokens.data(), count + 1, count == prompt, token);
+				x		= count;
+			}
+			for (; x < prompt && running; x += chunk) {
+				const uint64_t count = std::min(chunk, prompt - x);
+				running				 = run_batch(params, params.input_tokens + x, count, x + count == prompt, token);
+			}
+			for (size_t y = prompt > 0 ? 1 : 0; y < params.token_count + 1 && running; ++y) {
+				running = run_batch(params, &token, 1, true, token);
+			}
+			params.kv_cache_seq_len = this->current_sequence_length;
+			if constexpr (config.cache_strategy == kv_cache_strategy::hierarchical) {
+				if (kv_cache.is_active()) {
+					kv_cache.log_stats();
+				}
+			}
+			if (streamer.is_active()) {
+				streamer.log_stats();
+			}
+			if (prefetcher.is_active()) {
+				prefetcher.pump();
+				prefetcher.log_stats();
 			}
 			// Perform all of the necessary stuff to execute the model - along with all of the constexpr values stored globally inside the class LOL!.
 			// Because we only pay the "virtual overhead @ the top here == totally negligible.
@@ -94,6 +227,281 @@ namespace nihilus {
 	  protected:
 		memory_mapped_file model_data{};
 		memory_buffer<config> memory{};
+		memory_buffer<config> packed_weights{};
+		uint64_t packed_weights_size{};
+		kv_cache_tier<config> kv_cache{};
+		tokenizer_parameters<config.arch> tokenizer_params{};
+		tokenization_cache token_cache{};
+		std::vector<int32_t> generated_tokens{};
+		std::vector<std::vector<file_prefetch_chunk>> prefetch_ranges{};
+		static constexpr uint64_t prefetch_distance{ 2 };
+		weight_streamer<config> streamer{};
+		file_prefetcher prefetcher{};
+		weight_cache<config> cache{};
+		memory_locker locker{};
+
+		std::vector<int32_t> chunk_tokens{};
+		int32_t pending_token{ -1 };
+		bool first_pass{};
+
+		NIHILUS_FORCE_INLINE uint64_t get_prefill_chunk_size(const execution_parameters& params) const noexcept {
+			const uint64_t requested = params.batch_size > 0 ? params.batch_size : this->batch_size;
+			uint64_t chunk			 = requested > 0 ? std::min<uint64_t>(requested, model_traits_type::max_batch_size) : model_traits_type::max_batch_size;
+			if constexpr (config.cache_strategy == kv_cache_strategy::hierarchical) {
+				if (kv_cache.is_active()) {
+					chunk = std::min(chunk, kv_cache.get_batch_capacity());
+				}
+			}
+			return chunk;
+		}
+
+		// Writes the token ids, positions and causal mask rows for count positions starting at current_sequence_length - row y may attend to every
+		// cached position up to and including its own.
+		NIHILUS_FORCE_INLINE void fill_batch(const int32_t* tokens, uint64_t count) {
+			using mask_type		 = typename core_traits<config, op_type_type::kq_mask>::output_type;
+			auto* token_data	 = get_core<op_type_type::inp_tokens>().data;
+			auto* position_data	 = get_core<op_type_type::inp_pos>().data;
+			auto* mask_data		 = get_core<op_type_type::kq_mask>().data;
+			const uint64_t begin = this->current_sequence_length;
+			const uint64_t end	 = begin + count;
+			for (uint64_t x = 0; x < count; ++x) {
+				token_data[x]	 = tokens[x];
+				position_data[x] = static_cast<int32_t>(begin + x);
+				mask_type* row	 = mask_data + x * model_traits_type::max_sequence_length;
+				std::fill(row, row + begin + x + 1, mask_type{});
+				std::fill(row + begin + x + 1, row + end, -std::numeric_limits<mask_type>::infinity());
+			}
+			this->batch_token_count = count;
+			set_output_rows(count);
+		}
+
+		// One forward pass over count positions; when sample is set the last row picks the next token into token. Returns false once generation has to
+		// stop (context full, end token or a grammar dead end).
+		NIHILUS_FORCE_INLINE bool run_batch(execution_parameters& params, const int32_t* tokens, uint64_t count, bool sample, int32_t& token) {
+			if (this->current_sequence_length + count > this->context_length) {
+				log<log_level::error>("Context length of " + std::to_string(this->context_length) + " tokens reached.");
+				return false;
+			}
+			stop_watch_val_nihilus.reset();
+			if constexpr (config.cache_strategy == kv_cache_strategy::hierarchical) {
+				if (kv_cache.is_active()) {
+					kv_cache.advance(this->current_sequence_length + count - 1);
+					kv_cache.prefetch(0);
+				}
+			}
+			if (prefetcher.is_active()) {
+				for (uint64_t y = (first_pass ? 0 : prefetch_distance - 1); y < prefetch_distance; ++y) {
+					prefetch_step(y);
+				}
+			}
+			first_pass = false;
+			fill_batch(tokens, count);
+			auto& output_core = get_core<op_type_type::result_output>();
+			output_core.selector.prepare(params, this->output_row_count - 1, this->current_sequence_length + count - 1,
+				sample && params.constraint ? params.constraint->get_mask() : nullptr);
+			output_core.selector.set_active(sample);
+			this->execute_tasks();
+			this->current_sequence_length += count;
+			pending_token = -1;
+			if (!sample) {
+				stop_watch_val_nihilus.add_time();
+				return true;
+			}
+			token = output_core.selector.get_token();
+			if (token >= 0) {
+				generated_tokens.emplace_back(token);
+			}
+			const bool ended	= params.constraint && token == params.constraint->get_end_token();
+			const bool finished = params.constraint && (token < 0 || ended || !params.constraint->accept(token));
+			if (token >= 0 && (!finished || ended)) {
+				pending_token = token;
+			}
+			stop_watch_val_nihilus.add_time();
+			return !finished && token >= 0;
+		}
+
+		// Only the last position of a batch feeds the next token, so the last block gathers that single row and every global_output op - including the
+		// 128k-wide output projection - runs over one row rather than the whole sequence.
+		NIHILUS_FORCE_INLINE void set_output_rows(uint64_t token_count) {
+			get_core<op_type_type::inp_out_ids>().data[0] = static_cast<int32_t>(token_count - 1);
+			this->output_row_count						  = 1;
+		}
+
+		NIHILUS_FORCE_INLINE void repack_weights(const cli_params& params) {
+			const auto start = std::chrono::steady_clock::now();
+			core_bases_config_type::template impl<weight_repacker>(packed_weights_size);
+			packed_weights.init(packed_weights_size, params.huge_pages);
+			uint64_t repacked_bytes{};
+			core_bases_config_type::template impl<weight_repacker>(packed_weights, model_data, repacked_bytes);
+			const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			log<log_level::status>("weight_repacker: repacked " + std::to_string(repacked_bytes / (1024ull * 1024ull)) + " MB of q8_0 weights into " +
+				std::to_string(packed_q8_0_layout::rows_per_group) + "-row interleaved groups in " + std::to_string(elapsed) + " ms.");
+		}
+
+		// mbind only steers pages of the repacked copy, which is anonymous memory. Pages of the model mapping live in the shared page cache, which
+		// mbind does not place, so those rows are first-touched by the pinned workers of the node that consumes them - the page cache allocates on
+		// the faulting cpu's node. Pages already cached before the model loaded stay where they are.
+		NIHILUS_FORCE_INLINE void place_weights_on_nodes(bool packed) {
+			static constexpr uint64_t chunk_bytes{ 4ull * 1024ull * 1024ull };
+			std::vector<numa_weight_range> ranges{};
+			core_bases_config_type::template impl<numa_weight_binder>(this->numa, this->thread_count, this->partition, packed, ranges);
+			const uint8_t* model_begin = static_cast<const uint8_t*>(model_data.data());
+			const uint8_t* model_end   = model_begin + model_data.size();
+			std::vector<std::vector<numa_weight_range>> node_chunks(this->numa.node_count());
+			uint64_t bound_bytes{};
+			uint64_t touched_bytes{};
+			uint64_t resident_bytes{};
+			for (const auto& range: ranges) {
+				if (range.data < model_begin || range.data >= model_end) {
+					if (this->numa.bind_range(range.data, range.size, range.node)) {
+						bound_bytes += range.size;
+					}
+					continue;
+				}
+				resident_bytes += get_resident_bytes(range.data, range.size);
+				for (uint64_t x = 0; x < range.size; x += chunk_bytes) {
+					node_chunks[range.node].emplace_back(numa_weight_range{ range.data + x, std::min(chunk_bytes, range.size - x), range.node });
+				}
+				touched_bytes += range.size;
+			}
+			std::vector<std::atomic<uint64_t>> next_chunk(node_chunks.size());
+			this->run_on_workers([&](uint64_t thread_index, uint64_t thread_count) {
+				for (uint64_t x = 0; x < node_chunks.size(); ++x) {
+					const row_range node_threads = this->numa.get_node_thread_range(x, thread_count);
+					if (thread_index < node_threads.first || thread_index >= node_threads.last) {
+						continue;
+					}
+					const auto& chunks = node_chunks[x];
+					for (uint64_t y = next_chunk[x].fetch_add(1, std::memory_order_relaxed); y < chunks.size(); y = next_chunk[x].fetch_add(1, std::memory_order_relaxed)) {
+						page_in_range(chunks[y].data, chunks[y].size, page_in_mode::touch);
+					}
+				}
+			});
+			log<log_level::status>("numa_weight_binder: bound " + std::to_string(bound_bytes / (1024ull * 1024ull)) + " MB of repacked rows and first-touched " +
+				std::to_string(touched_bytes / (1024ull * 1024ull)) + " MB of mapped rows across " + std::to_string(this->numa.node_count()) + " nodes.");
+			if (resident_bytes >= 1024ull * 1024ull) {
+				log<log_level::status>("numa_weight_binder: " + std::to_string(resident_bytes / (1024ull * 1024ull)) +
+					" MB of mapped rows were already in the page cache and keep their node; drop the cache before loading to place them.");
+			}
+		}
+
+		// The workers pull fixed-size chunks off a shared counter, so the weights are faulted in roughly in the order the blocks consume them.
+		NIHILUS_FORCE_INLINE void page_in_weights(page_in_mode mode, bool packed) {
+			static constexpr uint64_t chunk_bytes{ 4ull * 1024ull * 1024ull };
+			std::vector<weight_range> ranges{};
+			core_bases_config_type::template impl<weight_range_collector>(packed, ranges);
+			if (streamer.is_active()) {
+				std::erase_if(ranges, [](const weight_range& range) {
+					return range.per_block;
+				});
+			}
+			std::stable_sort(ranges.begin(), ranges.end(), [](const weight_range& lhs, const weight_range& rhs) {
+				return lhs.block < rhs.block;
+			});
+			std::vector<weight_range> chunks{};
+			uint64_t total_bytes{};
+			for (const auto& range: ranges) {
+				for (uint64_t x = 0; x < range.size; x += chunk_bytes) {
+					chunks.emplace_back(weight_range{ range.data + x, range.location, std::min(chunk_bytes, range.size - x), range.block, range.per_block });
+				}
+				total_bytes += range.size;
+			}
+			std::atomic<uint64_t> next_chunk{};
+			std::atomic<uint64_t> checksum{};
+			const auto start = std::chrono::steady_clock::now();
+			this->run_on_workers([&](uint64_t, uint64_t) {
+				uint64_t local_checksum{};
+				for (uint64_t x = next_chunk.fetch_add(1, std::memory_order_relaxed); x < chunks.size(); x = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+					local_checksum += page_in_range(chunks[x].data, chunks[x].size, mode);
+				}
+				checksum.fetch_add(local_checksum, std::memory_order_relaxed);
+			});
+			const uint64_t elapsed_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+			const uint64_t megabytes_per_second = total_bytes / std::max<uint64_t>(elapsed_us, 1);
+			log<log_level::status>("page_in: " + std::to_string(total_bytes / (1024ull * 1024ull)) + " MB of weights in " + std::to_string(elapsed_us / 1000ull) +
+				" ms (" + std::to_string(megabytes_per_second / 1000ull) + "." + std::to_string(megabytes_per_second % 1000ull / 100ull) + " GB/s) with " +
+				std::to_string(this->thread_count) + " threads.");
+		}
+
+		// Weights are locked block by block in execution order, then the arena, so a limit too small for everything still pins the leading blocks.
+		// Streamed blocks live in the streamer's staging slots rather than in the mapping and are left alone.
+		NIHILUS_FORCE_INLINE void lock_memory(memory_lock_mode mode, bool packed) {
+			std::vector<weight_range> ranges{};
+			core_bases_config_type::template impl<weight_range_collector>(packed, ranges);
+			if (streamer.is_active()) {
+				std::erase_if(ranges, [](const weight_range& range) {
+					return range.per_block;
+				});
+			}
+			std::stable_sort(ranges.begin(), ranges.end(), [](const weight_range& lhs, const weight_range& rhs) {
+				return lhs.block < rhs.block;
+			});
+			const auto start = std::chrono::steady_clock::now();
+			locker.init();
+			uint64_t weight_bytes{};
+			for (const auto& range: ranges) {
+				weight_bytes += locker.lock(range.data, range.size);
+			}
+			uint64_t arena_bytes{};
+			if (mode == memory_lock_mode::weights_and_arena) {
+				arena_bytes = locker.lock(memory.data(), memory.size());
+			}
+			const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			log<log_level::status>("memory_locker: locking " + std::string{ get_memory_lock_mode_name(mode) } + " - " + std::to_string(weight_bytes / (1024ull * 1024ull)) +
+				" MB of weights and " + std::to_string(arena_bytes / (1024ull * 1024ull)) + " MB of arena in " + std::to_string(elapsed) + " ms.");
+			locker.log_stats();
+		}
+
+		NIHILUS_FORCE_INLINE void init_weight_streamer(const cli_params& params) {
+			std::vector<weight_range> ranges{};
+			core_bases_config_type::template impl<weight_range_collector>(false, ranges);
+			if (!streamer.init(params.model_file, model_data, ranges, this->thread_count + 1)) {
+				log<log_level::error>("weight_streamer: falling back to the memory-mapped weights.");
+			}
+		}
+
+		// Steps 0 .. block_count - 1 are the blocks and step block_count is the output weights; the execution loop requests step N + prefetch_distance
+		// as step N starts, wrapping into the next token. Only ranges still backed by the file are prefetched.
+		NIHILUS_FORCE_INLINE void init_file_prefetcher(const cli_params& params, bool packed) {
+			std::vector<weight_range> ranges{};
+			core_bases_config_type::template impl<weight_range_collector>(packed, ranges);
+			prefetch_ranges.assign(model_traits_type::block_count + 1, {});
+			const uint8_t* model_begin = static_cast<const uint8_t*>(model_data.data());
+			for (const auto& range: ranges) {
+				if ((!range.per_block && range.block != model_traits_type::block_count) || range.data < model_begin ||
+					range.data + range.size > model_begin + model_data.size()) {
+					continue;
+				}
+				prefetch_ranges[range.block].emplace_back(file_prefetch_chunk{ static_cast<uint64_t>(range.data - model_begin), range.size });
+			}
+			prefetcher.init(params.model_file, params.prefetch);
+		}
+
+		NIHILUS_FORCE_INLINE void prefetch_step(uint64_t step) {
+			for (const auto& chunk: prefetch_ranges[step]) {
+				prefetcher.prefetch(chunk.offset, chunk.size);
+			}
+			prefetcher.pump();
+		}
+
+		NIHILUS_FORCE_INLINE void init_kv_cache(const cli_params& params) {
+			using cache_k_type = core_traits<config, op_type_type::cache_k>;
+			using cache_v_type = core_traits<config, op_type_type::cache_v>;
+			array<array<void*, model_traits_type::block_count>, kv_cache_tier<config>::kind_count> hot_storage{};
+			for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
+				hot_storage[static_cast<uint64_t>(kv_cache_kind::key)][x]	= get_core<op_type_type::cache_k>().data[x];
+				hot_storage[static_cast<uint64_t>(kv_cache_kind::value)][x] = get_core<op_type_type::cache_v>().data[x];
+			}
+			const uint64_t batch_tokens = this->batch_size > 0 ? this->batch_size : model_traits_type::max_batch_size;
+			if (!kv_cache.init(params.kv_cache_file, this->context_length, params.kv_hot_page_count, batch_tokens,
+					std::min(cache_k_type::total_required_bytes, cache_v_type::total_required_bytes), hot_storage)) {
+				return;
+			}
+			for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
+				get_core<op_type_type::cache_k>().pages[x] = kv_cache.get_page_table(x, kv_cache_kind::key);
+				get_core<op_type_type::cache_v>().pages[x] = kv_cache.get_page_table(x, kv_cache_kind::value);
+			}
+		}
 	};
 
 }
@@ -29,7 +29,7 @@ namespace nihilus {
 		array<uint64_t, 4> dimensions{ { 1, 1, 1, 1 } };
 		uint32_t n_dimensions{};
 		mutable void* data{};
-		std::string name{};
+		std::string_view name{};
 		uint64_t offset{};
 		data_type type{};
 
@@ -62,12 +62,12 @@ namespace nihilus {
 
 	template<> struct tokenizer_parameters<model_arch::llama> {
 		std::vector<int64_t> token_types{};
-		std::vector<std::string> tokens{};
-		std::vector<std::string> merges{};
-		std::string chat_template{};
+		std::vector<std::string_view> tokens{};
+		std::vector<std::string_view> merges{};
+		std::string_view chat_template{};
 		uint64_t bos_token_id{};
 		uint64_t eos_token_id{};
-		std::string pre{};
+		std::string_view pre{};
 	};
 
 	template<model_arch arch> struct construction_parameters;
@@ -104,6 +104,7 @@ namespace nihilus {
 		std::unordered_map<op_type_type, core_base_creation_data> cores{};
 		tokenizer_parameters<config.arch> tokenizer_params{};
 		construction_parameters<config.arch> cparams{};
+		uint64_t tensor_data_offset{};
 	};
 
 }
\ No newline at end of file
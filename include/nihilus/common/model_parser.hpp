@@ -24,13 +24,30 @@ RealTimeChris (Chris M.)
 #include <nihilus/common/model_graph_data.hpp>
 #include <nihilus/common/debugging_io.hpp>
 #include <nihilus/common/model_traits.hpp>
+#include <nihilus/common/core_traits.hpp>
 #include <unordered_set>
-#include <variant>
 #include <fstream>
 #include <regex>
-#include <map>
 #include <bit>
 
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+	#include <io.h>
+	#ifndef PATH_MAX
+		#define PATH_MAX MAX_PATH
+	#endif
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#if defined(NIHIULUS_PLATFORM_LINUX)
+		#include <sys/resource.h>
+	#endif
+	#if defined(NIHIULUS_PLATFORM_MACOS)
+		#include <TargetConditionals.h>
+	#endif
+#endif
+
 namespace nihilus {
 
 	enum class gguf_metadata_value_type : uint32_t {
@@ -50,24 +67,6 @@ namespace nihilus {
 		GGUF_METADATA_VALUE_TYPE_UNSET	 = 13,
 	};
 
-#if defined(NIHILUS_PLATFORM_WINDOWS)
-	#include <io.h>
-	#ifndef PATH_MAX
-		#define PATH_MAX MAX_PATH
-	#endif
-#else
-	#include <sys/mman.h>
-	#include <sys/stat.h>
-	#include <fcntl.h>
-	#include <unistd.h>
-	#if defined(NIHIULUS_PLATFORM_LINUX)
-		#include <sys/resource.h>
-	#endif
-	#if defined(NIHIULUS_PLATFORM_MACOS)
-		#include <TargetConditionals.h>
-	#endif
-#endif
-
 #ifdef NIHILUS_PLATFORM_WINDOWS
 	NIHILUS_FORCE_INLINE std::string format_win_error(DWORD error_code) {
 		LPSTR buffer = nullptr;
@@ -93,9 +92,12 @@ namespace nihilus {
 	  public:
 		NIHILUS_FORCE_INLINE explicit memory_mapped_file() noexcept = default;
 
-		NIHILUS_FORCE_INLINE void init(std::string_view file_path_new, std::size_t prefetch_bytes = 0, bool numa_aware = false) {
+		NIHILUS_FORCE_INLINE void init(std::string_view file_path_new, std::size_t prefetch_bytes = 0, bool numa_aware = false, bool huge_pages = false) {
 			file_path_ = file_path_new;
 			map_file(file_path_, prefetch_bytes, numa_aware);
+			if (huge_pages) {
+				advise_huge_pages();
+			}
 		}
 
 		NIHILUS_FORCE_INLINE void deinit() {
@@ -336,6 +338,18 @@ namespace nihilus {
 #endif
 		}
 
+		NIHILUS_FORCE_INLINE void advise_huge_pages() {
+#if defined(NIHILUS_PLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+			if (mapped_data_ && madvise(mapped_data_, file_size_, MADV_HUGEPAGE) == 0) {
+				log<log_level::status>("memory_mapped_file: requested transparent huge pages for the weight mapping.");
+			} else {
+				log<log_level::status>("memory_mapped_file: transparent huge pages are unavailable for the weight mapping: " + std::string(std::strerror(errno)));
+			}
+#else
+			log<log_level::status>("memory_mapped_file: huge pages are not supported for the weight mapping on this platform.");
+#endif
+		}
+
 		NIHILUS_FORCE_INLINE void unmap_file() {
 #ifdef NIHILUS_PLATFORM_WINDOWS
 			if (mapped_data_) {
@@ -508,310 +522,269 @@ namespace nihilus {
 		}
 	};
 
-	using gguf_string_t = std::string;
-
-	struct gguf_array_t;
-
-	using gguf_metadata_value_variant = std::variant<float, uint64_t, int64_t, double, bool, gguf_string_t, gguf_array_t*>;
-
-	struct gguf_metadata_value_t {
-		gguf_metadata_value_t() noexcept = default;
-		gguf_metadata_value_t& operator=(const gguf_metadata_value_t& other) noexcept;
-		gguf_metadata_value_t(const gguf_metadata_value_t& other) noexcept {
-			*this = other;
-		};
-		gguf_metadata_value_t(const gguf_metadata_value_variant& other) noexcept;
-		~gguf_metadata_value_t();
-		gguf_metadata_value_variant value{};
-	};
-
-	struct gguf_array_t {
-		std::vector<gguf_metadata_value_t> array{};
-		gguf_metadata_value_type type{};
-	};
+	// Metadata is kept as views into the mapped file - keys and strings are never copied, and arrays (the 128k-entry vocab and merges) are only
+	// decoded when a caller gathers them.
+	template<typename value_type> NIHILUS_FORCE_INLINE value_type load_unaligned(const uint8_t* ptr) noexcept {
+		value_type value{};
+		std::memcpy(&value, ptr, sizeof(value_type));
+		return value;
+	}
 
-	gguf_metadata_value_t::~gguf_metadata_value_t() {
-		if (std::holds_alternative<gguf_array_t*>(value)) {
-			if (std::get<gguf_array_t*>(value)) {
-				delete std::get<gguf_array_t*>(value);
+	NIHILUS_FORCE_INLINE constexpr uint64_t get_metadata_scalar_size(gguf_metadata_value_type type) noexcept {
+		switch (type) {
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT8:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT8:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_BOOL: {
+				return 1;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT16:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT16: {
+				return 2;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT32:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT32:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT32: {
+				return 4;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT64:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT64:
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT64: {
+				return 8;
+			}
+			default: {
+				return 0;
 			}
 		}
 	}
 
-	gguf_metadata_value_t& gguf_metadata_value_t::operator=(const gguf_metadata_value_t& other) noexcept {
-		if (std::holds_alternative<float>(other.value)) {
-			value.emplace<float>(std::get<float>(other.value));
-		} else if (std::holds_alternative<uint64_t>(other.value)) {
-			value.emplace<uint64_t>(std::get<uint64_t>(other.value));
-		} else if (std::holds_alternative<int64_t>(other.value)) {
-			value.emplace<int64_t>(std::get<int64_t>(other.value));
-		} else if (std::holds_alternative<double>(other.value)) {
-			value.emplace<double>(std::get<double>(other.value));
-		} else if (std::holds_alternative<bool>(other.value)) {
-			value.emplace<bool>(std::get<bool>(other.value));
-		} else if (std::holds_alternative<gguf_string_t>(other.value)) {
-			value.emplace<gguf_string_t>(std::get<gguf_string_t>(other.value));
-		} else if (std::holds_alternative<gguf_array_t*>(other.value)) {
-			if (std::holds_alternative<gguf_array_t*>(value)) {
-				if (std::get<gguf_array_t*>(value)) {
-					delete std::get<gguf_array_t*>(value);
-				}
+	template<typename value_type> NIHILUS_FORCE_INLINE bool read_metadata_number(gguf_metadata_value_type type, const uint8_t* ptr, value_type& out) noexcept {
+		switch (type) {
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT8: {
+				out = static_cast<value_type>(load_unaligned<uint8_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT8: {
+				out = static_cast<value_type>(load_unaligned<int8_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT16: {
+				out = static_cast<value_type>(load_unaligned<uint16_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT16: {
+				out = static_cast<value_type>(load_unaligned<int16_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT32: {
+				out = static_cast<value_type>(load_unaligned<uint32_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT32: {
+				out = static_cast<value_type>(load_unaligned<int32_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT64: {
+				out = static_cast<value_type>(load_unaligned<uint64_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT64: {
+				out = static_cast<value_type>(load_unaligned<int64_t>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT32: {
+				out = static_cast<value_type>(load_unaligned<float>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT64: {
+				out = static_cast<value_type>(load_unaligned<double>(ptr));
+				return true;
+			}
+			case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_BOOL: {
+				out = static_cast<value_type>(load_unaligned<uint8_t>(ptr) != 0);
+				return true;
+			}
+			default: {
+				return false;
 			}
-			value.emplace<gguf_array_t*>(new gguf_array_t{ *std::get<gguf_array_t*>(other.value) });
-		}
-		return *this;
-	};
-
-	gguf_metadata_value_t::gguf_metadata_value_t(const gguf_metadata_value_variant& other) noexcept {
-		if (std::holds_alternative<float>(other)) {
-			value.emplace<float>(std::get<float>(other));
-		} else if (std::holds_alternative<uint64_t>(other)) {
-			value.emplace<uint64_t>(std::get<uint64_t>(other));
-		} else if (std::holds_alternative<int64_t>(other)) {
-			value.emplace<int64_t>(std::get<int64_t>(other));
-		} else if (std::holds_alternative<double>(other)) {
-			value.emplace<double>(std::get<double>(other));
-		} else if (std::holds_alternative<bool>(other)) {
-			value.emplace<bool>(std::get<bool>(other));
-		} else if (std::holds_alternative<gguf_string_t>(other)) {
-			value.emplace<gguf_string_t>(std::get<gguf_string_t>(other));
-		} else if (std::holds_alternative<gguf_array_t*>(other)) {
-			value.emplace<gguf_array_t*>(new gguf_array_t{ *std::get<gguf_array_t*>(other) });
 		}
-	};
+	}
 
-	template<> struct value_reader<gguf_string_t> {
-		NIHILUS_FORCE_INLINE static std::string gather_value(stream_iterator& input) {
+	template<> struct value_reader<std::string_view> {
+		NIHILUS_FORCE_INLINE static std::string_view gather_value(stream_iterator& input) {
 			uint64_t length = value_reader<uint64_t>::gather_value(input);
 			if (!input.has_bytes<char>(length)) {
 				throw std::runtime_error("Sorry, but that index is out of range!");
 			}
-			std::string result(length, '\0');
-			result.resize(length);
-			input.read_bytes_to_pointer(result.data(), length);
+			std::string_view result{ reinterpret_cast<const char*>(static_cast<uint8_t*>(input.file->data()) + input.current_index), length };
+			input.current_index += length;
 			return result;
 		}
 	};
 
-	template<> struct value_reader<gguf_array_t> {
-		NIHILUS_FORCE_INLINE static gguf_array_t gather_value(stream_iterator& input);
-	};
-
-	template<> struct value_reader<gguf_metadata_value_variant> {
-		NIHILUS_INLINE static gguf_metadata_value_variant gather_value(stream_iterator& input, gguf_metadata_value_type type) {
-			gguf_metadata_value_variant value{};
-			switch (type) {
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT8: {
-					value.emplace<int64_t>(value_reader<int8_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT16: {
-					value.emplace<int64_t>(value_reader<int16_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT32: {
-					value.emplace<int64_t>(value_reader<int32_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_INT64: {
-					value.emplace<int64_t>(value_reader<int64_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT8: {
-					value.emplace<uint64_t>(value_reader<uint8_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT16: {
-					value.emplace<uint64_t>(value_reader<uint16_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT32: {
-					value.emplace<uint64_t>(value_reader<uint32_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UINT64: {
-					value.emplace<uint64_t>(value_reader<uint64_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_BOOL: {
-					value.emplace<bool>(value_reader<bool>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT32: {
-					value.emplace<float>(value_reader<float>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_FLOAT64: {
-					value.emplace<double>(value_reader<double>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_STRING: {
-					value.emplace<gguf_string_t>(value_reader<gguf_string_t>::gather_value(input));
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_ARRAY: {
-					value.emplace<gguf_array_t*>(new gguf_array_t{ value_reader<gguf_array_t>::gather_value(input) });
-					break;
-				}
-				case gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_UNSET: {
-					break;
-				}
+	struct gguf_array_view {
+		gguf_metadata_value_type type{};
+		const uint8_t* data{};
+		uint64_t count{};
+
+		// Strings are length-prefixed, so they can only be walked in order.
+		template<typename function_type> NIHILUS_FORCE_INLINE void for_each_string(function_type&& function) const {
+			const uint8_t* current = data;
+			for (uint64_t x = 0; x < count; ++x) {
+				const uint64_t length = load_unaligned<uint64_t>(current);
+				function(std::string_view{ reinterpret_cast<const char*>(current + sizeof(uint64_t)), length });
+				current += sizeof(uint64_t) + length;
 			}
-			return value;
 		}
-	};
 
-	gguf_array_t value_reader<gguf_array_t>::gather_value(stream_iterator& input) {
-		gguf_metadata_value_type type{ value_reader<gguf_metadata_value_type>::gather_value(input) };
-		uint64_t length{ value_reader<uint64_t>::gather_value(input) };
-		constexpr uint64_t MAX_ARRAY_LENGTH = 1024 * 1024;
-		if (length > MAX_ARRAY_LENGTH) {
-			throw std::runtime_error{ "Array length exceeds maximum allowed size!" };
+		template<typename value_type> NIHILUS_FORCE_INLINE bool get(uint64_t index, value_type& out) const noexcept {
+			return index < count && read_metadata_number(type, data + index * get_metadata_scalar_size(type), out);
 		}
-		gguf_array_t value{};
-		value.type = type;
-		value.array.reserve(length);
-		for (uint64_t x = 0; x < length; ++x) {
-			value.array.emplace_back(value_reader<gguf_metadata_value_variant>::gather_value(input, type));
-		}
-		return value;
-	}
-
-	struct gguf_metadata_kv_t;
+	};
 
 	struct gguf_metadata_kv_t {
+		std::string_view key{};
+		const uint8_t* value{};
 		gguf_metadata_value_type value_type{};
 
-		gguf_metadata_value_t value{};
-
-		NIHILUS_FORCE_INLINE operator bool() const {
-			return std::get<bool>(value.value);
-		}
-
-		NIHILUS_FORCE_INLINE operator int64_t() const {
-			return std::get<int64_t>(value.value);
-		}
-
-		NIHILUS_FORCE_INLINE operator uint64_t() const {
-			return std::get<uint64_t>(value.value);
-		}
-
-		NIHILUS_FORCE_INLINE operator gguf_string_t() const {
-			return std::get<gguf_string_t>(value.value);
+		NIHILUS_FORCE_INLINE gguf_array_view get_array() const noexcept {
+			return { load_unaligned<gguf_metadata_value_type>(value), value + sizeof(uint32_t) + sizeof(uint64_t), load_unaligned<uint64_t>(value + sizeof(uint32_t)) };
 		}
 
-		NIHILUS_FORCE_INLINE operator gguf_array_t() const {
-			return *std::get<gguf_array_t*>(value.value);
-		}
-
-		NIHILUS_FORCE_INLINE operator float() const {
-			return std::get<float>(value.value);
-		}
-
-		NIHILUS_FORCE_INLINE operator double() const {
-			return std::get<double>(value.value);
+		NIHILUS_FORCE_INLINE std::string_view get_string() const noexcept {
+			return { reinterpret_cast<const char*>(value + sizeof(uint64_t)), load_unaligned<uint64_t>(value) };
 		}
 	};
 
-	template<> struct value_reader<gguf_metadata_kv_t> {
-		NIHILUS_FORCE_INLINE static gguf_metadata_kv_t gather_value(stream_iterator& input) {
-			gguf_metadata_kv_t value{};
-			value.value_type  = value_reader<gguf_metadata_value_type>::gather_value(input);
-			value.value.value = value_reader<gguf_metadata_value_variant>::gather_value(input, value.value_type);
-			return value;
+	// Advances past a value without decoding it; string arrays still need a walk over the length prefixes, but nothing is allocated. Recursive for
+	// nested arrays, so it cannot be force-inlined.
+	inline void skip_metadata_value(stream_iterator& input, gguf_metadata_value_type type) {
+		if (type == gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_STRING) {
+			value_reader<std::string_view>::gather_value(input);
+		} else if (type == gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_ARRAY) {
+			const gguf_metadata_value_type element_type{ value_reader<gguf_metadata_value_type>::gather_value(input) };
+			const uint64_t length{ value_reader<uint64_t>::gather_value(input) };
+			constexpr uint64_t MAX_ARRAY_LENGTH = 1024 * 1024;
+			if (length > MAX_ARRAY_LENGTH) {
+				throw std::runtime_error{ "Array length exceeds maximum allowed size!" };
+			}
+			const uint64_t element_size = get_metadata_scalar_size(element_type);
+			if (element_size > 0) {
+				if (!input.has_bytes(length * element_size)) {
+					throw std::runtime_error{ "Sorry, but that index is out of range!" };
+				}
+				input.current_index += length * element_size;
+			} else {
+				for (uint64_t x = 0; x < length; ++x) {
+					skip_metadata_value(input, element_type);
+				}
+			}
+		} else {
+			const uint64_t size = get_metadata_scalar_size(type);
+			if (size == 0 || !input.has_bytes(size)) {
+				throw std::runtime_error{ "Sorry, but that index is out of range!" };
+			}
+			input.current_index += size;
 		}
-	};
+	}
 
 	struct gguf_header_t {
-		std::map<std::string_view, gguf_metadata_kv_t> metadata_kv{};
+		std::vector<gguf_metadata_kv_t> metadata_kv{};
 		uint64_t metadata_kv_count{};
 		uint64_t tensor_count{};
 		uint32_t version{};
 		uint32_t magic{};
-	};
 
-	template<typename value_type> NIHILUS_FORCE_INLINE void gather_scalar(std::string_view key, value_type& out, const std::map<std::string_view, gguf_metadata_kv_t>& metadata_kv) {
-		auto it = metadata_kv.find(key);
-		if (it == metadata_kv.end())
-			return;
-		const auto& v = it->second.value.value;
-		if (std::holds_alternative<value_type>(v)) {
-			out = std::get<value_type>(v);
+		NIHILUS_FORCE_INLINE const gguf_metadata_kv_t* find(std::string_view key) const noexcept {
+			auto it = std::lower_bound(metadata_kv.begin(), metadata_kv.end(), key, [](const gguf_metadata_kv_t& lhs, std::string_view rhs) {
+				return lhs.key < rhs;
+			});
+			return it != metadata_kv.end() && it->key == key ? &*it : nullptr;
 		}
 	};
 
-	template<typename value_type>
-	NIHILUS_FORCE_INLINE void gather_array(std::string_view key, std::vector<value_type>& out, const std::map<std::string_view, gguf_metadata_kv_t>& metadata_kv) {
-		auto it = metadata_kv.find(key);
-		if (it == metadata_kv.end())
+	template<typename value_type> NIHILUS_FORCE_INLINE void gather_scalar(std::string_view key, value_type& out, const gguf_header_t& header) {
+		const gguf_metadata_kv_t* entry = header.find(key);
+		if (!entry) {
 			return;
-		const auto& v = it->second.value.value;
-		if (std::holds_alternative<gguf_array_t*>(v)) {
-			gguf_array_t& new_array{ *std::get<gguf_array_t*>(v) };
-			for (auto& value: new_array.array) {
-				out.emplace_back(std::get<value_type>(value.value));
+		}
+		if constexpr (std::is_same_v<value_type, std::string_view> || std::is_same_v<value_type, std::string>) {
+			if (entry->value_type == gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_STRING) {
+				out = value_type{ entry->get_string() };
 			}
+		} else {
+			read_metadata_number(entry->value_type, entry->value, out);
 		}
 	};
 
-	NIHILUS_FORCE_INLINE void print_variant(auto variant) {
-		if (std::holds_alternative<float>(variant)) {
-			std::cout << "Value: " << std::get<float>(variant) << std::endl;
-		} else if (std::holds_alternative<uint64_t>(variant)) {
-			std::cout << "Value: " << std::get<uint64_t>(variant) << std::endl;
-		} else if (std::holds_alternative<int64_t>(variant)) {
-			std::cout << "Value: " << std::get<int64_t>(variant) << std::endl;
-		} else if (std::holds_alternative<double>(variant)) {
-			std::cout << "Value: " << std::get<double>(variant) << std::endl;
-		} else if (std::holds_alternative<bool>(variant)) {
-			std::cout << "Value: " << std::get<bool>(variant) << std::endl;
-		} else if (std::holds_alternative<gguf_string_t>(variant)) {
-			std::cout << "Value: " << std::get<gguf_string_t>(variant) << std::endl;
-		} else if (std::holds_alternative<gguf_array_t*>(variant)) {
+	template<typename value_type> NIHILUS_FORCE_INLINE void gather_array(std::string_view key, std::vector<value_type>& out, const gguf_header_t& header) {
+		const gguf_metadata_kv_t* entry = header.find(key);
+		if (!entry || entry->value_type != gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_ARRAY) {
+			return;
 		}
-	}
+		const gguf_array_view array_view{ entry->get_array() };
+		out.reserve(out.size() + array_view.count);
+		if constexpr (std::is_same_v<value_type, std::string_view> || std::is_same_v<value_type, std::string>) {
+			if (array_view.type == gguf_metadata_value_type::GGUF_METADATA_VALUE_TYPE_STRING) {
+				array_view.for_each_string([&](std::string_view value) {
+					out.emplace_back(value);
+				});
+			}
+		} else {
+			for (uint64_t x = 0; x < array_view.count; ++x) {
+				value_type value{};
+				if (array_view.get(x, value)) {
+					out.emplace_back(value);
+				}
+			}
+		}
+	};
 
 	template<> struct value_reader<construction_parameters<model_arch::llama>, model_arch::llama> {
-		NIHILUS_FORCE_INLINE static construction_parameters<model_arch::llama> gather_value(const std::map<std::string_view, gguf_metadata_kv_t>& metadata_kv) {
+		NIHILUS_FORCE_INLINE static construction_parameters<model_arch::llama> gather_value(const gguf_header_t& header) {
 			construction_parameters<model_arch::llama> value{};
-			std::string architecture{};
-			if (metadata_kv.contains("general.architecture")) {
-				architecture = metadata_kv.at("general.architecture").operator gguf_string_t();
-			}
-			gather_scalar(architecture + ".rope.dimension_count", value.rope_dimension_count, metadata_kv);
-			gather_scalar(architecture + ".feed_forward_length", value.feed_forward_length, metadata_kv);
-			gather_scalar(architecture + ".embedding_length", value.embedding_length, metadata_kv);
-			gather_scalar(architecture + ".context_length", value.context_length, metadata_kv);
-			gather_scalar(architecture + ".attention.head_count_kv", value.head_count_kv, metadata_kv);
-			gather_scalar(architecture + ".block_count", value.block_count, metadata_kv);
-			gather_scalar(architecture + ".attention.head_count", value.head_count, metadata_kv);
-			gather_scalar(architecture + ".vocab_size", value.vocab_size, metadata_kv);
-			gather_scalar(architecture + ".rope.type", value.rope_type, metadata_kv);
-			gather_scalar(architecture + ".expert_count", value.n_expert, metadata_kv);
-			gather_scalar(architecture + ".expert_used_count", value.n_expert_used, metadata_kv);
-			gather_scalar(architecture + ".rope.freq_base", value.rope_freq_base, metadata_kv);
-			gather_scalar(architecture + ".rope.scaling.factor", value.rope_freq_scale, metadata_kv);
-			gather_scalar(architecture + ".rope.scaling.attn_factor", value.rope_attn_factor, metadata_kv);
-			gather_scalar(architecture + ".rope.scaling.beta_fast", value.rope_beta_fast, metadata_kv);
-			gather_scalar(architecture + ".rope.scaling.beta_slow", value.rope_beta_slow, metadata_kv);
-			gather_scalar(architecture + ".attention.layer_norm_rms_epsilon", value.rms_norm_epsilon, metadata_kv);
-			gather_scalar(architecture + ".attention.scale", value.f_attention_scale, metadata_kv);
-			gather_scalar(architecture + ".rope.scaling.ext_factor", value.rope_ext_factor, metadata_kv);
+			std::string_view architecture{};
+			gather_scalar("general.architecture", architecture, header);
+			std::string key{};
+			key.reserve(architecture.size() + 64);
+			auto arch_key = [&](std::string_view suffix) -> std::string_view {
+				key.assign(architecture);
+				key.append(suffix);
+				return key;
+			};
+			gather_scalar(arch_key(".rope.dimension_count"), value.rope_dimension_count, header);
+			gather_scalar(arch_key(".feed_forward_length"), value.feed_forward_length, header);
+			gather_scalar(arch_key(".embedding_length"), value.embedding_length, header);
+			gather_scalar(arch_key(".context_length"), value.context_length, header);
+			gather_scalar(arch_key(".attention.head_count_kv"), value.head_count_kv, header);
+			gather_scalar(arch_key(".block_count"), value.block_count, header);
+			gather_scalar(arch_key(".attention.head_count"), value.head_count, header);
+			gather_scalar(arch_key(".vocab_size"), value.vocab_size, header);
+			gather_scalar(arch_key(".rope.type"), value.rope_type, header);
+			gather_scalar(arch_key(".expert_count"), value.n_expert, header);
+			gather_scalar(arch_key(".expert_used_count"), value.n_expert_used, header);
+			gather_scalar(arch_key(".rope.freq_base"), value.rope_freq_base, header);
+			gather_scalar(arch_key(".rope.scaling.factor"), value.rope_freq_scale, header);
+			gather_scalar(arch_key(".rope.scaling.attn_factor"), value.rope_attn_factor, header);
+			gather_scalar(arch_key(".rope.scaling.beta_fast"), value.rope_beta_fast, header);
+			gather_scalar(arch_key(".rope.scaling.beta_slow"), value.rope_beta_slow, header);
+			gather_scalar(arch_key(".attention.layer_norm_rms_epsilon"), value.rms_norm_epsilon, header);
+			gather_scalar(arch_key(".attention.scale"), value.f_attention_scale, header);
+			gather_scalar(arch_key(".rope.scaling.ext_factor"), value.rope_ext_factor, header);
 
 			return value;
 		}
 	};
 
 	template<> struct value_reader<tokenizer_parameters<model_arch::llama>, model_arch::llama> {
-		NIHILUS_FORCE_INLINE static tokenizer_parameters<model_arch::llama> gather_value(const std::map<std::string_view, gguf_metadata_kv_t>& metadata_kv) {
+		NIHILUS_FORCE_INLINE static tokenizer_parameters<model_arch::llama> gather_value(const gguf_header_t& header) {
 			tokenizer_parameters<model_arch::llama> value{};
-			gather_scalar("tokenizer.ggml.bos_token_id", value.bos_token_id, metadata_kv);
-			gather_scalar("tokenizer.ggml.eos_token_id", value.eos_token_id, metadata_kv);
-			gather_scalar("tokenizer.chat_template", value.chat_template, metadata_kv);
-			gather_array("tokenizer.ggml.merges", value.merges, metadata_kv);
-			gather_scalar("tokenizer.ggml.pre", value.pre, metadata_kv);
-			gather_array("tokenizer.ggml.tokens", value.tokens, metadata_kv);
-			gather_array("tokenizer.ggml.token_type", value.token_types, metadata_kv);
+			gather_scalar("tokenizer.ggml.bos_token_id", value.bos_token_id, header);
+			gather_scalar("tokenizer.ggml.eos_token_id", value.eos_token_id, header);
+			gather_scalar("tokenizer.chat_template", value.chat_template, header);
+			gather_array("tokenizer.ggml.merges", value.merges, header);
+			gather_scalar("tokenizer.ggml.pre", value.pre, header);
+			gather_array("tokenizer.ggml.tokens", value.tokens, header);
+			gather_array("tokenizer.ggml.token_type", value.token_types, header);
 			return value;
 		}
 	};
@@ -834,66 +807,229 @@ namespace nihilus {
 			if (value.metadata_kv_count > MAX_METADATA_COUNT) {
 				throw std::runtime_error{ "Metadata count exceeds reasonable maximum!" };
 			}
+			value.metadata_kv.reserve(value.metadata_kv_count);
 			for (uint64_t x = 0; x < value.metadata_kv_count; ++x) {
-				std::string new_string		  = value_reader<gguf_string_t>::gather_value(input);
-				value.metadata_kv[new_string] = value_reader<gguf_metadata_kv_t>::gather_value(input);
+				gguf_metadata_kv_t entry{};
+				entry.key		 = value_reader<std::string_view>::gather_value(input);
+				entry.value_type = value_reader<gguf_metadata_value_type>::gather_value(input);
+				entry.value		 = static_cast<const uint8_t*>(input.file->data()) + input.current_index;
+				skip_metadata_value(input, entry.value_type);
+				value.metadata_kv.emplace_back(entry);
 			}
+			std::stable_sort(value.metadata_kv.begin(), value.metadata_kv.end(), [](const gguf_metadata_kv_t& lhs, const gguf_metadata_kv_t& rhs) {
+				return lhs.key < rhs.key;
+			});
 			return value;
 		}
 	};
 
 	template<model_arch arch> struct string_to_tensor_name;
 
+	struct tensor_name_entry {
+		std::string_view name{};
+		llama_op_types op{ llama_op_types::count };
+		bool per_block{};
+	};
+
+	// Tensor names are resolved through a perfect hash over the known suffixes ("blk.N." stripped), with the seed searched at compile time so that
+	// every suffix lands in its own slot - a lookup is one hash and one string compare.
+	template<typename entry_type, auto entry_count> struct perfect_hash_table {
+		static constexpr uint64_t slot_count{ std::bit_ceil(static_cast<uint64_t>(entry_count) * 2) };
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t hash(std::string_view input, uint64_t seed) noexcept {
+			uint64_t value = seed ^ input.size();
+			for (char c: input) {
+				value = (value ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+			}
+			return (value ^ (value >> 32)) & (slot_count - 1);
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr bool is_collision_free(const array<entry_type, entry_count>& entries, uint64_t seed) noexcept {
+			array<bool, slot_count> used{};
+			for (uint64_t x = 0; x < static_cast<uint64_t>(entry_count); ++x) {
+				const uint64_t slot = hash(entries[x].name, seed);
+				if (used[slot]) {
+					return false;
+				}
+				used[slot] = true;
+			}
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t find_seed(const array<entry_type, entry_count>& entries) noexcept {
+			uint64_t seed = 0xcbf29ce484222325ull;
+			while (!is_collision_free(entries, seed)) {
+				++seed;
+			}
+			return seed;
+		}
+
+		NIHILUS_FORCE_INLINE constexpr perfect_hash_table(const array<entry_type, entry_count>& entries) noexcept : seed{ find_seed(entries) } {
+			for (uint64_t x = 0; x < static_cast<uint64_t>(entry_count); ++x) {
+				slots[hash(entries[x].name, seed)] = entries[x];
+			}
+		}
+
+		NIHILUS_FORCE_INLINE constexpr const entry_type* find(std::string_view input) const noexcept {
+			const entry_type& entry = slots[hash(input, seed)];
+			return entry.name == input && !entry.name.empty() ? &entry : nullptr;
+		}
+
+	  protected:
+		array<entry_type, slot_count> slots{};
+		uint64_t seed{};
+	};
+
+	struct tensor_name_info {
+		llama_op_types op{ llama_op_types::count };
+		uint64_t block{};
+	};
+
+	inline constexpr array<tensor_name_entry, 13> llama_tensor_names{ { { "token_embd.weight", llama_op_types::token_embd_weight, false },
+		{ "rope_freqs.weight", llama_op_types::rope_freqs_weight, false }, { "output_norm.weight", llama_op_types::output_norm_weight, false },
+		{ "output.weight", llama_op_types::output_weight, false }, { "attn_q.weight", llama_op_types::attn_q_weight, true },
+		{ "attn_k.weight", llama_op_types::attn_k_weight, true }, { "attn_v.weight", llama_op_types::attn_v_weight, true },
+		{ "attn_output.weight", llama_op_types::attn_output_weight, true }, { "attn_norm.weight", llama_op_types::attn_norm_weight, true },
+		{ "ffn_gate.weight", llama_op_types::ffn_gate_weight, true }, { "ffn_up.weight", llama_op_types::ffn_up_weight, true },
+		{ "ffn_down.weight", llama_op_types::ffn_down_weight, true }, { "ffn_norm.weight", llama_op_types::ffn_norm_weight, true } } };
+
 	template<> struct string_to_tensor_name<model_arch::llama> {
-		NIHILUS_FORCE_INLINE static llama_op_types impl(std::string_view input) noexcept {
-			if (input == "token_embd.weight")
-				return llama_op_types::token_embd_weight;
-			if (input == "rope_freqs.weight")
-				return llama_op_types::rope_freqs_weight;
-			if (input == "output_norm.weight")
-				return llama_op_types::output_norm_weight;
-			if (input == "output.weight")
-				return llama_op_types::output_weight;
-
-			if (input.find(".attn_q.weight") != std::string_view::npos)
-				return llama_op_types::attn_q_weight;
-			if (input.find(".attn_norm.weight") != std::string_view::npos)
-				return llama_op_types::attn_norm_weight;
-
-			if (input.starts_with("blk.") && input.ends_with(".weight")) {
-				auto second_dot = input.find('.', 4);
-				if (second_dot != std::string_view::npos) {
-					auto suffix = input.substr(second_dot + 1);
-
-					if (suffix == "attn_q.weight")
-						return llama_op_types::attn_q_weight;
-					if (suffix == "attn_norm.weight")
-						return llama_op_types::attn_norm;
-					if (suffix == "attn_k.weight")
-						return llama_op_types::attn_k_weight;
-					if (suffix == "attn_v.weight")
-						return llama_op_types::attn_v_weight;
-					if (suffix == "ffn_down.weight")
-						return llama_op_types::ffn_down_weight;
-					if (suffix == "ffn_gate.weight")
-						return llama_op_types::ffn_gate_weight;
-					if (suffix == "attn_output.weight")
-						return llama_op_types::attn_output_weight;
-					if (suffix == "ffn_norm.weight")
-						return llama_op_types::ffn_norm_weight;
-					if (suffix == "ffn_up.weight")
-						return llama_op_types::ffn_up_weight;
+		static constexpr perfect_hash_table<tensor_name_entry, 13> table{ llama_tensor_names };
+
+		// "blk.N." is consumed in one pass, yielding the block index and the suffix to hash.
+		NIHILUS_FORCE_INLINE static constexpr tensor_name_info impl(std::string_view input) noexcept {
+			tensor_name_info return_value{};
+			bool per_block{};
+			if (input.size() > 4 && input[0] == 'b' && input[1] == 'l' && input[2] == 'k' && input[3] == '.') {
+				uint64_t x = 4;
+				for (; x < input.size() && input[x] >= '0' && input[x] <= '9'; ++x) {
+					return_value.block = return_value.block * 10 + static_cast<uint64_t>(input[x] - '0');
+				}
+				if (x == 4 || x >= input.size() || input[x] != '.') {
+					return return_value;
 				}
+				input	  = input.substr(x + 1);
+				per_block = true;
 			}
+			const tensor_name_entry* entry = table.find(input);
+			if (entry && entry->per_block == per_block) {
+				return_value.op = entry->op;
+			}
+			return return_value;
+		}
+	};
+
+	static_assert(string_to_tensor_name<model_arch::llama>::impl("blk.12.ffn_up.weight").op == llama_op_types::ffn_up_weight);
+	static_assert(string_to_tensor_name<model_arch::llama>::impl("blk.12.ffn_up.weight").block == 12);
+	static_assert(string_to_tensor_name<model_arch::llama>::impl("output.weight").op == llama_op_types::output_weight);
+	static_assert(string_to_tensor_name<model_arch::llama>::impl("blk.3.output.weight").op == llama_op_types::count);
+
+	struct expected_tensor_layout {
+		array<uint64_t, 4> dims{};
+		data_type type{};
+		bool per_block{};
+		bool required{};
+	};
 
-			return llama_op_types::count;
+	NIHILUS_FORCE_INLINE constexpr std::string_view get_data_type_name(data_type type) noexcept {
+		switch (type) {
+			case data_type::f32: {
+				return "f32";
+			}
+			case data_type::f16: {
+				return "f16";
+			}
+			case data_type::q8_0: {
+				return "q8_0";
+			}
+			default: {
+				return "unknown";
+			}
+		}
+	}
+
+	NIHILUS_FORCE_INLINE std::string dims_to_string(const array<uint64_t, 4>& dims) {
+		return "[" + std::to_string(dims[0]) + ", " + std::to_string(dims[1]) + ", " + std::to_string(dims[2]) + ", " + std::to_string(dims[3]) + "]";
+	}
+
+	// Checks a parsed GGUF against the shapes and types the compile-time graph was built for, so that a file for a different model size or kernel
+	// profile is rejected at load time with every mismatch listed, instead of being run.
+	template<model_config config> struct tensor_validator {
+		using model_traits_type = model_traits<config.arch, config.model_size, config.model_generation>;
+		static constexpr uint64_t op_count{ static_cast<uint64_t>(llama_op_types::count) };
+
+		template<uint64_t... indices> NIHILUS_FORCE_INLINE static constexpr array<expected_tensor_layout, op_count> get_expected_layouts(std::index_sequence<indices...>) noexcept {
+			array<expected_tensor_layout, op_count> return_value{};
+			((return_value[static_cast<uint64_t>(llama_tensor_names[indices].op)] = expected_tensor_layout{ core_traits<config, llama_tensor_names[indices].op>::dims,
+				  type_traits<typename core_traits<config, llama_tensor_names[indices].op>::output_type>::type, llama_tensor_names[indices].per_block,
+				  llama_tensor_names[indices].op != llama_op_types::rope_freqs_weight && llama_tensor_names[indices].op != llama_op_types::output_weight }),
+				...);
+			return return_value;
+		}
+
+		static constexpr array<expected_tensor_layout, op_count> expected_layouts{ get_expected_layouts(std::make_index_sequence<llama_tensor_names.size()>{}) };
+
+		NIHILUS_FORCE_INLINE static void check_value(std::string& diff, std::string_view name, uint64_t expected, uint64_t found) {
+			if (expected != found) {
+				diff += "\n\t" + std::string{ name } + ": expected " + std::to_string(expected) + ", found " + std::to_string(found);
+			}
+		}
+
+		NIHILUS_FORCE_INLINE static void impl(const std::vector<core_base_creation_data>& tensor_infos, const construction_parameters<model_arch::llama>& cparams,
+			const tokenizer_parameters<model_arch::llama>& tokenizer_params) {
+			std::string diff{};
+			check_value(diff, "embedding_length", model_traits_type::embedding_dim, cparams.embedding_length);
+			check_value(diff, "block_count", model_traits_type::block_count, cparams.block_count);
+			check_value(diff, "feed_forward_length", model_traits_type::feed_forward_length, cparams.feed_forward_length);
+			check_value(diff, "attention.head_count", model_traits_type::head_count, cparams.head_count);
+			check_value(diff, "attention.head_count_kv", model_traits_type::head_count_kv, cparams.head_count_kv);
+			check_value(diff, "rope.dimension_count", model_traits_type::rope_dimension_count, cparams.rope_dimension_count);
+			check_value(diff, "vocab_size", model_traits_type::vocab_size, cparams.vocab_size > 0 ? cparams.vocab_size : tokenizer_params.tokens.size());
+			// A missing rope.freq_base reads as 0 and falls back to the default in hyper_parameters, so only a value that cannot be a base is rejected.
+			if (!(cparams.rope_freq_base >= 0.0)) {
+				diff += "\n\trope.freq_base: negative or NaN";
+			}
+			if (!(cparams.rms_norm_epsilon > 0.0) || cparams.rms_norm_epsilon > 1.0) {
+				diff += "\n\tattention.layer_norm_rms_epsilon: missing or out of range";
+			}
+
+			array<array<bool, model_traits_type::block_count>, op_count> seen{};
+			for (const auto& tensor: tensor_infos) {
+				const tensor_name_info info{ string_to_tensor_name<model_arch::llama>::impl(tensor.name) };
+				if (info.op == llama_op_types::count || info.block >= model_traits_type::block_count) {
+					continue;
+				}
+				const expected_tensor_layout& expected = expected_layouts[static_cast<uint64_t>(info.op)];
+				seen[static_cast<uint64_t>(info.op)][info.block] = true;
+				if (tensor.dimensions != expected.dims) {
+					diff += "\n\t" + std::string{ tensor.name } + ": expected dims " + dims_to_string(expected.dims) + ", found " + dims_to_string(tensor.dimensions);
+				}
+				if (tensor.type != expected.type) {
+					diff += "\n\t" + std::string{ tensor.name } + ": expected type " + std::string{ get_data_type_name(expected.type) } + ", found " +
+						std::string{ get_data_type_name(tensor.type) } + " (" + std::to_string(static_cast<uint64_t>(tensor.type)) + ")";
+				}
+			}
+			for (uint64_t y = 0; y < llama_tensor_names.size(); ++y) {
+				const tensor_name_entry& entry = llama_tensor_names[y];
+				if (!expected_layouts[static_cast<uint64_t>(entry.op)].required) {
+					continue;
+				}
+				for (uint64_t x = 0; x < (entry.per_block ? model_traits_type::block_count : 1); ++x) {
+					if (!seen[static_cast<uint64_t>(entry.op)][x]) {
+						diff += "\n\t" + (entry.per_block ? "blk." + std::to_string(x) + "." : std::string{}) + std::string{ entry.name } + ": missing";
+					}
+				}
+			}
+			if (!diff.empty()) {
+				throw std::runtime_error{ "The model file does not match the compiled model config:" + diff };
+			}
 		}
 	};
 
 	template<> struct value_reader<core_base_creation_data> {
 		NIHILUS_FORCE_INLINE static core_base_creation_data gather_value(stream_iterator& input) {
 			core_base_creation_data value{};
-			value.name						  = value_reader<gguf_string_t>::gather_value(input);
+			value.name						  = value_reader<std::string_view>::gather_value(input);
 			value.n_dimensions				  = value_reader<uint32_t>::gather_value(input);
 			constexpr uint32_t MAX_DIMENSIONS = 8;
 			if (value.n_dimensions > MAX_DIMENSIONS) {
@@ -913,62 +1049,6 @@ namespace nihilus {
 		}
 	};
 
-	NIHILUS_FORCE_INLINE bool operator<(const core_base_creation_data& lhs, const core_base_creation_data& rhs) noexcept {
-		std::string_view lhs_name{ lhs.name };
-		std::string_view rhs_name{ rhs.name };
-		if (lhs_name.find_first_of("1234567890") != std::string::npos && rhs_name.find_first_of("1234567890") != std::string::npos) {
-			uint64_t lhs_offset{ lhs_name.find_first_of("1234567890") };
-			uint64_t rhs_offset{ rhs_name.find_first_of("1234567890") };
-			std::string lhs_val_raw{ lhs_name.substr(lhs_offset, lhs_name.find_first_not_of("1234567890", lhs_offset) - lhs_offset + 1) };
-			std::string rhs_val_raw{ rhs_name.substr(rhs_offset, rhs_name.find_first_not_of("1234567890", rhs_offset) - rhs_offset + 1) };
-			auto* lhs_ptr_01 = lhs_val_raw.data();
-			auto* lhs_ptr_02 = lhs_val_raw.data() + lhs_val_raw.size();
-			uint64_t lhs_val{ std::strtoull(lhs_ptr_01, &lhs_ptr_02, 10) };
-			auto* rhs_ptr_01 = rhs_val_raw.data();
-			auto* rhs_ptr_02 = rhs_val_raw.data() + rhs_val_raw.size();
-			uint64_t rhs_val{ std::strtoull(rhs_ptr_01, &rhs_ptr_02, 10) };
-			return lhs_val < rhs_val;
-		} else {
-			return lhs_name < rhs_name;
-		}
-	}
-
-	NIHILUS_FORCE_INLINE void sort_tensor_infos(std::vector<core_base_creation_data>& tensor_infos) noexcept {
-		std::sort(tensor_infos.begin(), tensor_infos.end(), std::less<core_base_creation_data>{});
-	}
-
-	NIHILUS_FORCE_INLINE constexpr uint64_t parse_number(std::string_view str) noexcept {
-		uint64_t result = 0;
-		for (char c: str) {
-			if (c >= '0' && c <= '9') {
-				result = result * 10 + (c - '0');
-			} else {
-				break;
-			}
-		}
-		return result;
-	}
-
-	NIHILUS_FORCE_INLINE uint64_t extract_layer_number(std::string_view name) noexcept {
-		if NIHILUS_LIKELY (name[0] == 'c' && name.starts_with("cache_")) {
-			for (uint64_t i = 7; i < name.size(); ++i) {
-				if (name[i] == 'l' && i + 1 < name.size()) {
-					return parse_number(name.substr(i + 1));
-				}
-			}
-			return 0;
-		}
-		if NIHILUS_LIKELY (name[0] == 'b' && name.starts_with("blk.")) {
-			uint64_t start = 4;
-			uint64_t end   = name.find('.', start);
-			if (end != std::string_view::npos) {
-				return parse_number(name.substr(start, end - start));
-			}
-		}
-
-		return 0;
-	}
-
 	struct gguf_file_t {
 		std::vector<core_base_creation_data> tensor_infos{};
 		std::vector<uint8_t> tensor_data{};
@@ -1009,16 +1089,39 @@ namespace nihilus {
 
 			uint64_t tensor_data_start = 0;
 			uint64_t alignment{ 32 };
-			gather_scalar("alignment", alignment, gguf_file.header.metadata_kv);
-			return_value.cparams		  = value_reader<construction_parameters<model_arch::llama>, model_arch::llama>::gather_value(gguf_file.header.metadata_kv);
-			return_value.tokenizer_params = value_reader<tokenizer_parameters<model_arch::llama>, model_arch::llama>::gather_value(gguf_file.header.metadata_kv);
-			sort_tensor_infos(gguf_file.tensor_infos);
-			for (uint64_t x = 0; x < gguf_file.tensor_infos.size(); ++x) {
-				ptr.map_pointer(data[string_to_tensor_name<model_arch::llama>::impl(gguf_file.tensor_infos[x].name)][extract_layer_number(gguf_file.tensor_infos[x].name)],
-					gguf_file.tensor_infos[x].core_total_byte_size());
+			gather_scalar("general.alignment", alignment, gguf_file.header);
+			return_value.cparams		  = value_reader<construction_parameters<model_arch::llama>, model_arch::llama>::gather_value(gguf_file.header);
+			return_value.tokenizer_params = value_reader<tokenizer_parameters<model_arch::llama>, model_arch::llama>::gather_value(gguf_file.header);
+			return_value.tensor_data_offset = align_offset(ptr.current_index, alignment);
+			tensor_validator<config>::impl(gguf_file.tensor_infos, return_value.cparams, return_value.tokenizer_params);
+			for (const auto& tensor: gguf_file.tensor_infos) {
+				const tensor_name_info info{ string_to_tensor_name<model_arch::llama>::impl(tensor.name) };
+				if (info.op == llama_op_types::count || info.block >= model_traits_type::block_count) {
+					log<log_level::status>("model_parser: skipping unrecognized tensor " + std::string{ tensor.name });
+					continue;
+				}
+				if (return_value.tensor_data_offset + tensor.offset + tensor.core_total_byte_size() > model_data.size()) {
+					throw std::runtime_error{ "Tensor data extends past the end of the file: " + std::string{ tensor.name } };
+				}
+				*static_cast<void**>(data[static_cast<uint64_t>(info.op)][info.block]) =
+					static_cast<uint8_t*>(model_data.data()) + return_value.tensor_data_offset + tensor.offset;
+			}
+			// Tied embeddings (e.g. Llama 3.2 1B and 3B) ship no output.weight: the output projection reads token_embd.weight, which has the same
+			// dims and type.
+			void*& output_weight = *static_cast<void**>(data[static_cast<uint64_t>(llama_op_types::output_weight)][0]);
+			if (!output_weight) {
+				output_weight = *static_cast<void**>(data[static_cast<uint64_t>(llama_op_types::token_embd_weight)][0]);
+				log<log_level::status>("model_parser: no output.weight, using token_embd.weight for the output projection.");
 			}
 			return return_value;
 		}
+
+		// Used when the weight cache supplied the tensor pointers: only the metadata is read, and the strings still point into the mapping.
+		NIHILUS_FORCE_INLINE static tokenizer_parameters<model_arch::llama> parse_tokenizer(memory_mapped_file& model_data) {
+			stream_iterator ptr{ &model_data };
+			const gguf_header_t header{ value_reader<gguf_header_t>::gather_value(ptr) };
+			return value_reader<tokenizer_parameters<model_arch::llama>, model_arch::llama>::gather_value(header);
+		}
 	};
 
 	template<model_config config> struct model_parser;
@@ -1031,5 +1134,9 @@ namespace nihilus {
 			memory_mapped_file& model_data) {
 			return model_parser_impl<config, config.arch, config.format>::parse_model(path, data, model_data);
 		}
+
+		NIHILUS_FORCE_INLINE static tokenizer_parameters<config.arch> parse_tokenizer(memory_mapped_file& model_data) {
+			return model_parser_impl<config, config.arch, config.format>::parse_tokenizer(model_data);
+		}
 	};
 }
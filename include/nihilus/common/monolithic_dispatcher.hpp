@@ -28,18 +28,18 @@ namespace nihilus {
 
 	template<model_config config, device_type dev_type, single_input core_type> struct kernel_dispatcher
 		: public kernel_traits<core_type::type, core_type::krn_type, core_type, typename core_type::output_type, typename core_type::input_type01::output_type> {
-		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count) {
+		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count, const work_partition& partition) {
 			kernel_dispatcher_impl<cpu_arch_index, core_type::krn_type, typename core_type::transform_type, core_type, typename core_type::output_type,
-				typename core_type::input_type01::output_type>::impl(thread_index, thread_count, params, get_adjacent_value<config, core_type::type, 0>::impl(params));
+				typename core_type::input_type01::output_type>::impl(thread_index, thread_count, partition, params, get_adjacent_value<config, core_type::type, 0>::impl(params));
 		}
 	};
 
 	template<model_config config, device_type dev_type, double_input core_type> struct kernel_dispatcher<config, dev_type, core_type>
 		: public kernel_traits<core_type::type, core_type::krn_type, core_type, typename core_type::output_type, typename core_type::input_type01::output_type,
 			  typename core_type::input_type02::output_type> {
-		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count) {
+		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count, const work_partition& partition) {
 			kernel_dispatcher_impl<cpu_arch_index, core_type::krn_type, typename core_type::transform_type, core_type, typename core_type::output_type,
-				typename core_type::input_type01::output_type, typename core_type::input_type02::output_type>::impl(thread_index, thread_count, params,
+				typename core_type::input_type01::output_type, typename core_type::input_type02::output_type>::impl(thread_index, thread_count, partition, params,
 				get_adjacent_value<config, core_type::type, 0>::impl(params), get_adjacent_value<config, core_type::type, 1>::impl(params));
 		}
 	};
@@ -47,10 +47,10 @@ namespace nihilus {
 	template<model_config config, device_type dev_type, triple_input core_type> struct kernel_dispatcher<config, dev_type, core_type>
 		: public kernel_traits<core_type::type, core_type::krn_type, core_type, typename core_type::output_type, typename core_type::input_type01::output_type,
 			  typename core_type::input_type02::output_type, typename core_type::input_type03::output_type> {
-		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count) {
+		NIHILUS_FORCE_INLINE static void impl(core_type& params, size_t thread_index, size_t thread_count, const work_partition& partition) {
 			kernel_dispatcher_impl<cpu_arch_index, core_type::krn_type, typename core_type::transform_type, core_type, typename core_type::output_type,
 				typename core_type::input_type01::output_type, typename core_type::input_type02::output_type, typename core_type::input_type03::output_type>::impl(thread_index,
-				thread_count, params, get_adjacent_value<config, core_type::type, 0>::impl(params), get_adjacent_value<config, core_type::type, 1>::impl(params),
+				thread_count, partition, params, get_adjacent_value<config, core_type::type, 0>::impl(params), get_adjacent_value<config, core_type::type, 1>::impl(params),
 				get_adjacent_value<config, core_type::type, 2>::impl(params));
 		}
 	};
@@ -0,0 +1,374 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+
+#pragma once
+
+#include <nihilus/cpu/topology.hpp>
+#include <nihilus/common/common.hpp>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <bit>
+#include <vector>
+
+namespace nihilus {
+
+	struct argmax_result {
+		float value{ -std::numeric_limits<float>::infinity() };
+		int32_t index{ -1 };
+	};
+
+	// Larger value wins, the smaller index on ties, so the result does not depend on how the row was split.
+	NIHILUS_FORCE_INLINE argmax_result merge_argmax(argmax_result lhs, argmax_result rhs) noexcept {
+		if (rhs.index < 0) {
+			return lhs;
+		}
+		if (lhs.index < 0 || rhs.value > lhs.value || (rhs.value == lhs.value && rhs.index < lhs.index)) {
+			return rhs;
+		}
+		return lhs;
+	}
+
+	// Index of the largest value in [values, values + count), -1 if there is none (empty or all NaN/-inf); ISA headers specialize this.
+	template<uint64_t arch_index> struct argmax_kernel {
+		NIHILUS_FORCE_INLINE static argmax_result impl(const float* values, uint64_t count) noexcept {
+			argmax_result result{};
+			for (uint64_t x = 0; x < count; ++x) {
+				if (values[x] > result.value) {
+					result = argmax_result{ values[x], static_cast<int32_t>(x) };
+				}
+			}
+			return result;
+		}
+	};
+
+	// Appends first + x to output for every values[x] > threshold (NaN never passes) and returns how many were written; ISA headers specialize this.
+	template<uint64_t arch_index> struct threshold_select_kernel {
+		NIHILUS_FORCE_INLINE static uint64_t impl(const float* values, uint64_t count, float threshold, uint32_t first, uint32_t* output) noexcept {
+			uint64_t size{};
+			for (uint64_t x = 0; x < count; ++x) {
+				if (values[x] > threshold) {
+					output[size++] = first + static_cast<uint32_t>(x);
+				}
+			}
+			return size;
+		}
+	};
+
+	// Sum of exp((values[x] - maximum) * scale) with every values[x] <= maximum; ISA headers specialize this with a polynomial exp.
+	template<uint64_t arch_index> struct exp_sum_kernel {
+		NIHILUS_FORCE_INLINE static float impl(const float* values, uint64_t count, float maximum, float scale) noexcept {
+			float sum{};
+			for (uint64_t x = 0; x < count; ++x) {
+				sum += values[x] > -std::numeric_limits<float>::infinity() ? std::exp((values[x] - maximum) * scale) : 0.0f;
+			}
+			return sum;
+		}
+	};
+
+	// Sets values[x] to -inf wherever bit (first + x) of mask is clear; ISA headers specialize this.
+	template<uint64_t arch_index> struct token_mask_kernel {
+		NIHILUS_FORCE_INLINE static void impl(float* values, uint64_t count, const uint64_t* mask, uint64_t first) noexcept {
+			for (uint64_t x = 0; x < count; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+		}
+	};
+
+	// Counter-based draw: the value depends only on (seed, counter), so a sequence replays exactly whatever ran before it.
+	NIHILUS_FORCE_INLINE float get_uniform_random(uint64_t seed, uint64_t counter) noexcept {
+		uint64_t value = seed ^ (counter * 0x9E3779B97F4A7C15ull);
+		for (uint64_t x = 0; x < 2; ++x) {
+			value += 0x9E3779B97F4A7C15ull;
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			value ^= value >> 31;
+		}
+		return static_cast<float>(value >> 40) * 0x1.0p-24f;
+	}
+
+	struct sampler_candidate {
+		float logit{};
+		int32_t id{};
+	};
+
+	// Top-k, then top-p, then temperature, in that order. The vocabulary is never sorted: a SIMD pass keeps only logits above a running k-th value,
+	// and only the survivors are sorted. Top-p without top-k starts from the best nucleus_candidates and, when those do not cover the nucleus, falls
+	// back to a weighted quickselect over the row. All buffers are sized by init, so sampling does not allocate.
+	struct token_sampler {
+		static constexpr uint64_t block_size{ 4096 };
+		static constexpr uint64_t select_block_size{ 512 };
+		static constexpr uint64_t nucleus_candidates{ 64 };
+
+		NIHILUS_FORCE_INLINE void init(uint64_t vocab_size) {
+			indices.resize(vocab_size);
+			candidates.reserve(vocab_size);
+			weights.reserve(vocab_size);
+			block_sums.resize((vocab_size + block_size - 1) / block_size);
+		}
+
+		// Returns -1 only when no logit is finite.
+		template<uint64_t arch_index = cpu_arch_index>
+		NIHILUS_FORCE_INLINE int32_t sample(const float* logits, uint64_t count, const execution_parameters& params, uint64_t counter) noexcept {
+			const bool use_top_p = params.top_p > 0.0f && params.top_p < 1.0f;
+			if (params.temperature <= 0.0f || (params.top_k <= 0 && !use_top_p)) {
+				const argmax_result best = argmax_kernel<arch_index>::impl(logits, count);
+				if (params.temperature <= 0.0f || best.index < 0) {
+					return best.index;
+				}
+				const int32_t token = sample_full<arch_index>(logits, count, best.value, 1.0f / params.temperature, get_uniform_random(params.random_seed, counter));
+				return token >= 0 ? token : best.index;
+			}
+			const uint64_t keep = params.top_k > 0 ? std::min<uint64_t>(static_cast<uint64_t>(params.top_k), count) : std::min(nucleus_candidates, count);
+			select_top<arch_index>(logits, count, keep);
+			if (candidates.empty()) {
+				return -1;
+			}
+			const float maximum = candidates.front().logit;
+			uint64_t cut		= candidates.size();
+			if (use_top_p) {
+				// Measured on the untempered distribution, over the top-k survivors when top-k is set and over the whole row otherwise. Every logit
+				// outside the candidates is at most the last one, which bounds the row's mass from above; when the candidates' own mass and that bound
+				// give the same cut, the exact total cannot move it and the pass over the row is skipped.
+				weights.resize(candidates.size());
+				float candidate_mass{};
+				for (uint64_t x = 0; x < candidates.size(); ++x) {
+					weights[x] = std::exp(candidates[x].logit - maximum);
+					candidate_mass += weights[x];
+				}
+				float total{ candidate_mass };
+				cut = get_nucleus_cut(params.top_p * total);
+				if (params.top_k <= 0 && get_nucleus_cut(params.top_p * (candidate_mass + static_cast<float>(count - candidates.size()) * weights.back())) != cut) {
+					total = exp_sum_kernel<arch_index>::impl(logits, count, maximum, 1.0f);
+					cut	  = get_nucleus_cut(params.top_p * total);
+				}
+				if (cut > candidates.size()) {
+					cut = params.top_k <= 0 && candidates.size() == keep && keep < count ? select_nucleus(logits, count, maximum, params.top_p * total) : candidates.size();
+				}
+			}
+			const float inverse_temperature = 1.0f / params.temperature;
+			weights.resize(cut);
+			float total{};
+			for (uint64_t x = 0; x < cut; ++x) {
+				weights[x] = std::exp((candidates[x].logit - maximum) * inverse_temperature);
+				total += weights[x];
+			}
+			const float target = get_uniform_random(params.random_seed, counter) * total;
+			float cumulative{};
+			for (uint64_t x = 0; x < cut; ++x) {
+				cumulative += weights[x];
+				if (cumulative > target) {
+					return candidates[x].id;
+				}
+			}
+			return candidates[cut - 1].id;
+		}
+
+	  protected:
+		std::vector<uint32_t> indices{};
+		std::vector<sampler_candidate> candidates{};
+		std::vector<float> weights{};
+		std::vector<float> block_sums{};
+
+		// Leaves the keep largest finite logits in candidates, sorted descending.
+		template<uint64_t arch_index> NIHILUS_FORCE_INLINE void select_top(const float* logits, uint64_t count, uint64_t keep) noexcept {
+			const auto greater = [logits](uint32_t lhs, uint32_t rhs) {
+				return logits[lhs] > logits[rhs] || (logits[lhs] == logits[rhs] && lhs < rhs);
+			};
+			float threshold{ -std::numeric_limits<float>::infinity() };
+			uint64_t size{};
+			for (uint64_t first = 0; first < count; first += select_block_size) {
+				size += threshold_select_kernel<arch_index>::impl(logits + first, std::min(select_block_size, count - first), threshold, static_cast<uint32_t>(first),
+					indices.data() + size);
+				if (size >= keep * 2) {
+					std::nth_element(indices.begin(), indices.begin() + static_cast<int64_t>(keep - 1), indices.begin() + static_cast<int64_t>(size), greater);
+					size	  = keep;
+					threshold = logits[indices[keep - 1]];
+				}
+			}
+			const uint64_t kept = std::min(size, keep);
+			std::partial_sort(indices.begin(), indices.begin() + static_cast<int64_t>(kept), indices.begin() + static_cast<int64_t>(size), greater);
+			candidates.clear();
+			for (uint64_t x = 0; x < kept; ++x) {
+				candidates.emplace_back(sampler_candidate{ logits[indices[x]], static_cast<int32_t>(indices[x]) });
+			}
+		}
+
+		// Length of the shortest prefix of the candidates whose weights reach limit, or one past the end when they do not.
+		NIHILUS_FORCE_INLINE uint64_t get_nucleus_cut(float limit) const noexcept {
+			float cumulative{};
+			uint64_t cut{};
+			while (cut < candidates.size() && cumulative < limit) {
+				cumulative += weights[cut++];
+			}
+			return cumulative >= limit ? std::max<uint64_t>(cut, 1) : candidates.size() + 1;
+		}
+
+		// Top-p over the whole row when the first nucleus_candidates do not cover it: a weighted quickselect finds the shortest descending prefix whose
+		// mass reaches target without sorting it. Leaves that prefix, unordered, at the front of candidates and returns its length. The masses are
+		// summed in double: near-flat rows put tens of thousands of tokens in the nucleus, and a float sum drifts the cut by dozens of them.
+		NIHILUS_FORCE_INLINE uint64_t select_nucleus(const float* logits, uint64_t count, float maximum, float target) noexcept {
+			const auto greater = [](const sampler_candidate& lhs, const sampler_candidate& rhs) {
+				return lhs.logit > rhs.logit || (lhs.logit == rhs.logit && lhs.id < rhs.id);
+			};
+			candidates.clear();
+			for (uint64_t x = 0; x < count; ++x) {
+				if (logits[x] > -std::numeric_limits<float>::infinity()) {
+					candidates.emplace_back(sampler_candidate{ logits[x], static_cast<int32_t>(x) });
+				}
+			}
+			uint64_t first{};
+			uint64_t last{ candidates.size() };
+			double above{};
+			while (last - first > 1) {
+				const uint64_t middle = first + (last - first) / 2;
+				std::nth_element(candidates.begin() + static_cast<int64_t>(first), candidates.begin() + static_cast<int64_t>(middle),
+					candidates.begin() + static_cast<int64_t>(last), greater);
+				double mass{};
+				for (uint64_t x = first; x < middle; ++x) {
+					mass += std::exp(candidates[x].logit - maximum);
+				}
+				if (above + mass >= target) {
+					last = middle;
+				} else {
+					above += mass;
+					first = middle;
+				}
+			}
+			return last;
+		}
+
+		// No truncation: pick a block by its tempered mass, then walk that block.
+		template<uint64_t arch_index>
+		NIHILUS_FORCE_INLINE int32_t sample_full(const float* logits, uint64_t count, float maximum, float inverse_temperature, float random) noexcept {
+			float total{};
+			const uint64_t block_count = (count + block_size - 1) / block_size;
+			for (uint64_t x = 0; x < block_count; ++x) {
+				block_sums[x] = exp_sum_kernel<arch_index>::impl(logits + x * block_size, std::min(block_size, count - x * block_size), maximum, inverse_temperature);
+				total += block_sums[x];
+			}
+			float target = random * total;
+			uint64_t block{};
+			while (block + 1 < block_count && target >= block_sums[block]) {
+				target -= block_sums[block++];
+			}
+			int32_t last{ -1 };
+			float cumulative{};
+			for (uint64_t x = block * block_size; x < std::min(count, (block + 1) * block_size); ++x) {
+				if (logits[x] > -std::numeric_limits<float>::infinity()) {
+					cumulative += std::exp((logits[x] - maximum) * inverse_temperature);
+					last = static_cast<int32_t>(x);
+					if (cumulative > target) {
+						break;
+					}
+				}
+			}
+			return last;
+		}
+	};
+
+	// Token choice over one row of logits, fused into the phase that produces them. Greedy decoding has every worker reduce the slice it just wrote and
+	// the last one to arrive fold the partials; otherwise the last worker to arrive runs the sampler over the finished row. Either way the token is
+	// ready when the phase's end latch opens and the main thread never touches the logits.
+	struct token_selector {
+		NIHILUS_FORCE_INLINE void init(uint64_t thread_count, uint64_t vocab_size) {
+			partials.resize(thread_count);
+			arrivals.store(0, std::memory_order_release);
+			sampler.init(vocab_size);
+		}
+
+		// A token mask (one bit per vocabulary entry, set = allowed) is applied by each worker to its own slice before the slice is reduced.
+		NIHILUS_FORCE_INLINE void prepare(const execution_parameters& params_new, uint64_t row_new, uint64_t counter_new, const uint64_t* mask_new = nullptr) noexcept {
+			params	= &params_new;
+			mask	= mask_new;
+			row		= row_new;
+			counter = counter_new;
+			active	= true;
+			token	= -1;
+		}
+
+		// Phases whose logits are not needed (e.g. all but the last prefill chunk) skip selection entirely.
+		NIHILUS_FORCE_INLINE void set_active(bool active_new) noexcept {
+			active = active_new && params;
+			token  = -1;
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return active;
+		}
+
+		template<uint64_t granularity = 1, uint64_t arch_index = cpu_arch_index>
+		NIHILUS_FORCE_INLINE void reduce(uint64_t thread_index, uint64_t thread_count, const work_partition& partition, float* logits, uint64_t row_size) noexcept {
+			if (!active) {
+				return;
+			}
+			float* values		  = logits + row * row_size;
+			const bool greedy	  = params->temperature <= 0.0f;
+			const row_range range = partition.get_range(thread_index, thread_count, row_size, granularity);
+			if (mask) {
+				token_mask_kernel<arch_index>::impl(values + range.first, range.last - range.first, mask, range.first);
+			}
+			if (greedy) {
+				argmax_result result = argmax_kernel<arch_index>::impl(values + range.first, range.last - range.first);
+				if (result.index >= 0) {
+					result.index += static_cast<int32_t>(range.first);
+				}
+				partials[thread_index].result = result;
+			}
+			if (arrivals.fetch_add(1, std::memory_order_acq_rel) + 1 == thread_count) {
+				if (greedy) {
+					argmax_result best{};
+					for (uint64_t x = 0; x < thread_count; ++x) {
+						best = merge_argmax(best, partials[x].result);
+					}
+					token = best.index;
+				} else {
+					token = sampler.template sample<arch_index>(values, row_size, *params, counter);
+				}
+				arrivals.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		// Valid once the phase has completed.
+		NIHILUS_FORCE_INLINE int32_t get_token() const noexcept {
+			return token;
+		}
+
+	  protected:
+		struct alignas(64) partial {
+			argmax_result result{};
+		};
+
+		std::vector<partial> partials{};
+		alignas(64) std::atomic<uint64_t> arrivals{};
+		token_sampler sampler{};
+		const execution_parameters* params{};
+		const uint64_t* mask{};
+		uint64_t counter{};
+		int32_t token{ -1 };
+		uint64_t row{};
+		bool active{};
+	};
+
+}
@@ -20,21 +20,958 @@ RealTimeChris (Chris M.)
 
 #pragma once
 
-#include <nihilus/common/tokenizer.hpp>
+#include <nihilus/common/model_graph_data.hpp>
+#include <nihilus/common/unicode.hpp>
 #include <nihilus/common/config.hpp>
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
 #include <iterator>
+#include <string>
+#include <bit>
+#include <vector>
+
+#if defined(NIHILUS_NEON)
+	#include <arm_neon.h>
+#endif
 
 namespace nihilus {
 
+	// Values of tokenizer.ggml.token_type.
+	enum class token_attribute : int64_t {
+		undefined,
+		normal,
+		unknown,
+		control,
+		user_defined,
+		unused,
+		byte,
+	};
+
+	NIHILUS_FORCE_INLINE constexpr uint64_t hash_token_text(std::string_view text) noexcept {
+		uint64_t hash{ 0xcbf29ce484222325ull };
+		for (char c: text) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+		}
+		return hash ^ (hash >> 32);
+	}
+
+	// Open-addressing map from token text to id; the slots keep the upper hash bits so a probe only compares strings on a likely hit.
+	struct token_text_table {
+		struct slot {
+			uint32_t tag{};
+			int32_t id{ -1 };
+		};
+
+		NIHILUS_FORCE_INLINE void init(const std::vector<std::string_view>& tokens) {
+			uint64_t capacity{ 16 };
+			while (capacity < tokens.size() * 2) {
+				capacity *= 2;
+			}
+			slots.assign(capacity, slot{});
+			mask = capacity - 1;
+			for (uint64_t x = 0; x < tokens.size(); ++x) {
+				const uint64_t hash = hash_token_text(tokens[x]);
+				uint64_t index		= hash & mask;
+				while (slots[index].id != -1) {
+					if (slots[index].tag == static_cast<uint32_t>(hash >> 32) && tokens[static_cast<uint64_t>(slots[index].id)] == tokens[x]) {
+						break;
+					}
+					index = (index + 1) & mask;
+				}
+				if (slots[index].id == -1) {
+					slots[index] = slot{ static_cast<uint32_t>(hash >> 32), static_cast<int32_t>(x) };
+				}
+			}
+		}
+
+		NIHILUS_FORCE_INLINE int32_t find(const std::vector<std::string_view>& tokens, std::string_view text) const noexcept {
+			const uint64_t hash = hash_token_text(text);
+			for (uint64_t index = hash & mask; slots[index].id != -1; index = (index + 1) & mask) {
+				if (slots[index].tag == static_cast<uint32_t>(hash >> 32) && tokens[static_cast<uint64_t>(slots[index].id)] == text) {
+					return slots[index].id;
+				}
+			}
+			return -1;
+		}
+
+	  protected:
+		std::vector<slot> slots{};
+		uint64_t mask{};
+	};
+
+	// Open-addressing map from a (left, right) symbol pair to its merge rank and the symbol the merge produces.
+	struct bpe_merge_table {
+		static constexpr uint64_t empty_key{ ~0ull };
+
+		struct slot {
+			uint64_t key{ empty_key };
+			uint32_t rank{};
+			int32_t result{};
+		};
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_key(int32_t left, int32_t right) noexcept {
+			return static_cast<uint64_t>(static_cast<uint32_t>(left)) << 32 | static_cast<uint32_t>(right);
+		}
+
+		NIHILUS_FORCE_INLINE void init(uint64_t count) {
+			uint64_t capacity{ 16 };
+			while (capacity < count * 2) {
+				capacity *= 2;
+			}
+			slots.assign(capacity, slot{});
+			mask = capacity - 1;
+		}
+
+		// The first merge listed for a pair wins, as in the reference implementation.
+		NIHILUS_FORCE_INLINE void insert(int32_t left, int32_t right, uint32_t rank, int32_t result) noexcept {
+			const uint64_t key = get_key(left, right);
+			uint64_t index	   = hash_key(key) & mask;
+			while (slots[index].key != empty_key) {
+				if (slots[index].key == key) {
+					return;
+				}
+				index = (index + 1) & mask;
+			}
+			slots[index] = slot{ key, rank, result };
+		}
+
+		NIHILUS_FORCE_INLINE const slot* find(int32_t left, int32_t right) const noexcept {
+			const uint64_t key = get_key(left, right);
+			for (uint64_t index = hash_key(key) & mask; slots[index].key != empty_key; index = (index + 1) & mask) {
+				if (slots[index].key == key) {
+					return &slots[index];
+				}
+			}
+			return nullptr;
+		}
+
+	  protected:
+		std::vector<slot> slots{};
+		uint64_t mask{};
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t hash_key(uint64_t key) noexcept {
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			return key ^ (key >> 33);
+		}
+	};
+
+	// One bit per byte of a 32-byte block. Non-ASCII bytes only set non_ascii; the code points they start are classified by the scalar path.
+	struct ascii_block_masks {
+		uint32_t letter{};
+		uint32_t number{};
+		uint32_t whitespace{};
+		uint32_t non_ascii{};
+	};
+
+	static constexpr uint64_t ascii_block_size{ 32 };
+
+#if defined(NIHILUS_NEON)
+	NIHILUS_FORCE_INLINE uint32_t get_byte_mask(uint8x16_t low, uint8x16_t high) noexcept {
+		static constexpr uint8_t weights[16]{ 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		const uint8x16_t weight = vld1q_u8(weights);
+		const uint8x16_t bits_low  = vandq_u8(low, weight);
+		const uint8x16_t bits_high = vandq_u8(high, weight);
+		uint8x8_t sum = vpadd_u8(vpadd_u8(vget_low_u8(bits_low), vget_high_u8(bits_low)), vpadd_u8(vget_low_u8(bits_high), vget_high_u8(bits_high)));
+		sum			  = vpadd_u8(sum, sum);
+		return vget_lane_u32(vreinterpret_u32_u8(sum), 0);
+	}
+#endif
+
+	NIHILUS_FORCE_INLINE ascii_block_masks classify_ascii_block(const char* data) noexcept {
+		ascii_block_masks return_value{};
+#if defined(NIHILUS_AVX2) || defined(NIHILUS_AVX512)
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+		// byte - first lies in [0, count) exactly when byte - first - 128 < count - 128 as a signed compare.
+		const auto in_range = [](__m256i value, int8_t first, int8_t count) {
+			const __m256i biased = _mm256_add_epi8(value, _mm256_set1_epi8(static_cast<char>(-128 - first)));
+			return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + count)), biased);
+		};
+		return_value.letter		= static_cast<uint32_t>(_mm256_movemask_epi8(in_range(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 26)));
+		return_value.number		= static_cast<uint32_t>(_mm256_movemask_epi8(in_range(bytes, '0', 10)));
+		return_value.whitespace = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(in_range(bytes, '\t', 5), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')))));
+		return_value.non_ascii	= static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+#elif defined(NIHILUS_NEON)
+		const uint8x16_t low  = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+		const uint8x16_t high = vld1q_u8(reinterpret_cast<const uint8_t*>(data) + 16);
+		const auto in_range	  = [](uint8x16_t value, uint8_t first, uint8_t count) {
+			  return vcltq_u8(vsubq_u8(value, vdupq_n_u8(first)), vdupq_n_u8(count));
+		};
+		const auto is_whitespace = [&](uint8x16_t value) {
+			return vorrq_u8(in_range(value, '\t', 5), vceqq_u8(value, vdupq_n_u8(' ')));
+		};
+		const uint8x16_t case_bit = vdupq_n_u8(0x20);
+		return_value.letter		  = get_byte_mask(in_range(vorrq_u8(low, case_bit), 'a', 26), in_range(vorrq_u8(high, case_bit), 'a', 26));
+		return_value.number		  = get_byte_mask(in_range(low, '0', 10), in_range(high, '0', 10));
+		return_value.whitespace	  = get_byte_mask(is_whitespace(low), is_whitespace(high));
+		return_value.non_ascii	  = get_byte_mask(vcgeq_u8(low, vdupq_n_u8(0x80)), vcgeq_u8(high, vdupq_n_u8(0x80)));
+#else
+		for (uint64_t x = 0; x < ascii_block_size; ++x) {
+			const uint8_t byte = static_cast<uint8_t>(data[x]);
+			const uint32_t bit = 1u << x;
+			if (byte >= 0x80) {
+				return_value.non_ascii |= bit;
+				continue;
+			}
+			const unicode_class type = ascii_classes[byte];
+			return_value.letter |= type == unicode_class::letter ? bit : 0;
+			return_value.number |= type == unicode_class::number ? bit : 0;
+			return_value.whitespace |= type == unicode_class::whitespace ? bit : 0;
+		}
+#endif
+		return return_value;
+	}
+
+	NIHILUS_FORCE_INLINE constexpr uint32_t get_class_mask(const ascii_block_masks& masks, unicode_class type) noexcept {
+		switch (type) {
+			case unicode_class::letter: {
+				return masks.letter;
+			}
+			case unicode_class::number: {
+				return masks.number;
+			}
+			case unicode_class::whitespace: {
+				return masks.whitespace;
+			}
+			case unicode_class::other: {
+				return ~(masks.letter | masks.number | masks.whitespace | masks.non_ascii);
+			}
+			default: {
+				return 0;
+			}
+		}
+	}
+
+	// Turns a stream of token pieces into text that only ever breaks on UTF-8 boundaries: a trailing partial sequence is held back (at most three
+	// bytes) and prepended to the next piece. The returned view points into a buffer sized once by init and stays valid until the next call.
+	struct incremental_detokenizer {
+		NIHILUS_FORCE_INLINE void init(uint64_t max_piece_length) {
+			buffer.reserve(max_piece_length + 4);
+			buffer.clear();
+		}
+
+		NIHILUS_FORCE_INLINE std::string_view push(std::string_view piece) noexcept {
+			buffer.erase(0, emitted);
+			buffer.append(piece);
+			emitted = buffer.size() - get_incomplete_utf8_suffix(buffer);
+			return std::string_view{ buffer.data(), emitted };
+		}
+
+		// Returns whatever is still held back, e.g. at the end of generation.
+		NIHILUS_FORCE_INLINE std::string_view flush() noexcept {
+			buffer.erase(0, emitted);
+			emitted = buffer.size();
+			return buffer;
+		}
+
+		NIHILUS_FORCE_INLINE void reset() noexcept {
+			buffer.clear();
+			emitted = 0;
+		}
+
+	  protected:
+		std::string buffer{};
+		uint64_t emitted{};
+	};
+
+	struct tokenization_cache_stats {
+		uint64_t lookups{};
+		uint64_t hits{};
+		uint64_t insertions{};
+		uint64_t evictions{};
+		uint64_t reused_tokens{};
+		uint64_t entry_count{};
+		uint64_t used_bytes{};
+	};
+
+	// LRU map from prompt prefixes to their token ids, shared by every session of a model. A prefix always ends right after a special token (a
+	// message boundary in chat templates), where tokenization restarts from scratch, so splicing the cached ids in front of the rest is exact. Entries
+	// keep their text and the add_bos/parse_special flags they were produced with and are compared on lookup, so a hash collision is only a miss.
+	struct tokenization_cache {
+		struct entry {
+			std::string text{};
+			std::vector<int32_t> tokens{};
+			uint64_t last_use{};
+			uint32_t flags{};
+		};
+
+		NIHILUS_FORCE_INLINE void init(uint64_t capacity_bytes_new) {
+			std::unique_lock lock{ mutex };
+			capacity_bytes = capacity_bytes_new;
+			entries.clear();
+			stats = {};
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return capacity_bytes > 0;
+		}
+
+		// Looks the prefixes text[0, lengths[x]) up from the longest down, appends the tokens of the first hit to output and returns its index, or -1.
+		NIHILUS_FORCE_INLINE int64_t find(std::string_view text, const uint64_t* hashes, const uint64_t* lengths, uint64_t count, uint32_t flags,
+			std::vector<int32_t>& output) {
+			std::unique_lock lock{ mutex };
+			++stats.lookups;
+			for (uint64_t x = count; x-- > 0;) {
+				auto iterator = entries.find(hashes[x]);
+				if (iterator != entries.end() && iterator->second.flags == flags && iterator->second.text == text.substr(0, lengths[x])) {
+					iterator->second.last_use = ++clock;
+					output.insert(output.end(), iterator->second.tokens.begin(), iterator->second.tokens.end());
+					++stats.hits;
+					stats.reused_tokens += iterator->second.tokens.size();
+					return static_cast<int64_t>(x);
+				}
+			}
+			return -1;
+		}
+
+		NIHILUS_FORCE_INLINE void insert(uint64_t hash, std::string_view text, uint32_t flags, const int32_t* tokens, uint64_t count) {
+			const uint64_t bytes = get_entry_bytes(text.size(), count);
+			std::unique_lock lock{ mutex };
+			if (bytes > capacity_bytes) {
+				return;
+			}
+			if (auto iterator = entries.find(hash); iterator != entries.end()) {
+				stats.used_bytes -= get_entry_bytes(iterator->second.text.size(), iterator->second.tokens.size());
+				entries.erase(iterator);
+			}
+			while (stats.used_bytes + bytes > capacity_bytes) {
+				auto oldest = entries.begin();
+				if (oldest == entries.end()) {
+					break;
+				}
+				for (auto iterator = std::next(oldest); iterator != entries.end(); ++iterator) {
+					if (iterator->second.last_use < oldest->second.last_use) {
+						oldest = iterator;
+					}
+				}
+				stats.used_bytes -= get_entry_bytes(oldest->second.text.size(), oldest->second.tokens.size());
+				entries.erase(oldest);
+				++stats.evictions;
+			}
+			entries.emplace(hash, entry{ std::string{ text }, std::vector<int32_t>(tokens, tokens + count), ++clock, flags });
+			stats.used_bytes += bytes;
+			++stats.insertions;
+		}
+
+		NIHILUS_FORCE_INLINE tokenization_cache_stats get_stats() {
+			std::unique_lock lock{ mutex };
+			tokenization_cache_stats return_value{ stats };
+			return_value.entry_count = entries.size();
+			return return_value;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() {
+			const tokenization_cache_stats current{ get_stats() };
+			const double hit_rate = current.lookups > 0 ? 100.0 * static_cast<double>(current.hits) / static_cast<double>(current.lookups) : 0.0;
+			log<log_level::status>("tokenization_cache: " + std::to_string(current.hits) + "/" + std::to_string(current.lookups) + " hits (" + std::to_string(hit_rate) +
+				"%), " + std::to_string(current.reused_tokens) + " tokens reused, " + std::to_string(current.entry_count) + " entries, " +
+				std::to_string(current.used_bytes / 1024ull) + " of " + std::to_string(capacity_bytes / 1024ull) + " KB, " + std::to_string(current.evictions) +
+				" evictions.");
+		}
+
+	  protected:
+		std::unordered_map<uint64_t, entry> entries{};
+		tokenization_cache_stats stats{};
+		uint64_t capacity_bytes{};
+		uint64_t clock{};
+		std::mutex mutex{};
+
+		NIHILUS_FORCE_INLINE static uint64_t get_entry_bytes(uint64_t text_size, uint64_t token_count) noexcept {
+			return sizeof(entry) + text_size + token_count * sizeof(int32_t);
+		}
+	};
+
 	template<model_arch arch> struct tokenizer;
 
+	// Byte-level BPE with the LLaMA-3 pre-tokenizer, following llama.cpp's llm_tokenizer_bpe: special tokens are split out first, each remaining
+	// fragment is cut into words, and each word is either looked up whole (ignore_merges) or merged from its bytes lowest rank first. Symbols are
+	// tracked as ids - a merge whose text is not in the vocabulary gets an id past the end of it - so the merge loop never builds strings.
 	template<> struct tokenizer<model_arch::llama> {
+		using token_type = int32_t;
+		static constexpr token_type invalid_token{ -1 };
+
 		NIHILUS_FORCE_INLINE tokenizer() noexcept = default;
 
-		template<typename token_input_type> NIHILUS_FORCE_INLINE void tokenize(std::string_view, token_input_type*) {
-			return;
+		NIHILUS_FORCE_INLINE void init(const tokenizer_parameters<model_arch::llama>& params) {
+			tokens		 = params.tokens;
+			bos_token_id = static_cast<token_type>(params.bos_token_id);
+			text_table.init(tokens);
+			ignore_merges = params.pre == "llama3" || params.pre == "llama-v3" || params.pre == "llama-bpe" || params.pre == "falcon3";
+			if (!params.pre.empty() && !ignore_merges) {
+				log<log_level::status>("tokenizer: pre-tokenizer \"" + std::string{ params.pre } + "\" is not implemented, using the LLaMA-3 split.");
+			}
+			init_symbols(params.merges);
+			init_special_tokens(params.token_types);
+			init_pieces(params.token_types);
+			log<log_level::status>("tokenizer: " + std::to_string(tokens.size()) + " tokens, " + std::to_string(params.merges.size()) + " merges, " +
+				std::to_string(special_tokens.size()) + " special tokens.");
+		}
+
+		NIHILUS_FORCE_INLINE bool is_initialized() const noexcept {
+			return !tokens.empty();
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t vocab_size() const noexcept {
+			return tokens.size();
+		}
+
+		// Bytes the token stands for. Control and unknown tokens are empty unless special is set; user-defined tokens are their text verbatim.
+		NIHILUS_FORCE_INLINE std::string_view get_piece(token_type id, bool special = false) const noexcept {
+			if (static_cast<uint64_t>(id) >= tokens.size() || (!special && piece_is_special[static_cast<uint64_t>(id)])) {
+				return {};
+			}
+			return std::string_view{ piece_bytes.data() + piece_offsets[static_cast<uint64_t>(id)],
+				piece_offsets[static_cast<uint64_t>(id) + 1] - piece_offsets[static_cast<uint64_t>(id)] };
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t max_piece_length() const noexcept {
+			return max_piece_size;
+		}
+
+		// Appends the tokens of text to output. User-defined tokens are always matched verbatim; control tokens only when parse_special is set.
+		NIHILUS_FORCE_INLINE void tokenize(std::string_view text, std::vector<token_type>& output, bool add_bos = true, bool parse_special = true) {
+			const uint64_t start					  = output.size();
+			text									  = sanitize_utf8(text);
+			const std::vector<special_match>& matches = find_special_tokens(text, parse_special);
+			const bool use_cache					  = cache && cache->is_active() && !matches.empty();
+			int64_t hit{ -1 };
+			const uint32_t cache_flags				  = (add_bos ? 1u : 0u) | (parse_special ? 2u : 0u);
+			if (use_cache) {
+				get_prefix_hashes(text, matches, cache_flags);
+				hit = cache->find(text, prefix_hashes.data(), prefix_lengths.data(), matches.size(), cache_flags, output);
+			}
+			uint64_t position{};
+			if (hit >= 0) {
+				position = prefix_lengths[static_cast<uint64_t>(hit)];
+			} else if (add_bos && bos_token_id >= 0) {
+				output.emplace_back(bos_token_id);
+			}
+			uint64_t prefix_token_count{};
+			for (uint64_t x = static_cast<uint64_t>(hit + 1); x < matches.size(); ++x) {
+				tokenize_fragment(text.substr(position, matches[x].offset - position), output);
+				output.emplace_back(special_tokens[matches[x].special_index].id);
+				position		   = matches[x].offset + tokens[static_cast<uint64_t>(special_tokens[matches[x].special_index].id)].size();
+				prefix_token_count = output.size() - start;
+			}
+			tokenize_fragment(text.substr(position), output);
+			if (use_cache && static_cast<uint64_t>(hit + 1) < matches.size()) {
+				cache->insert(prefix_hashes[matches.size() - 1], text.substr(0, prefix_lengths[matches.size() - 1]), cache_flags, output.data() + start,
+					prefix_token_count);
+			}
+		}
+
+		// Every session of a model shares its cache; null disables caching.
+		NIHILUS_FORCE_INLINE void set_cache(tokenization_cache* cache_new) noexcept {
+			cache = cache_new;
 		}
-	};
 
+		// Writes at most capacity tokens and returns the full token count, so a return value above capacity means the output was truncated.
+		template<typename token_input_type>
+		NIHILUS_FORCE_INLINE uint64_t tokenize(std::string_view text, token_input_type* output, uint64_t capacity, bool add_bos = true, bool parse_special = true) {
+			token_scratch.clear();
+			tokenize(text, token_scratch, add_bos, parse_special);
+			const uint64_t count = std::min<uint64_t>(capacity, token_scratch.size());
+			for (uint64_t x = 0; x < count; ++x) {
+				output[x] = static_cast<token_input_type>(token_scratch[x]);
+			}
+			return token_scratch.size();
+		}
+
+	  protected:
+		struct special_token {
+			token_type id{};
+			bool control{};
+		};
+
+		struct special_match {
+			uint64_t special_index{};
+			uint64_t offset{};
+		};
+
+		struct symbol {
+			token_type id{};
+			int32_t prev{};
+			int32_t next{};
+		};
+
+		struct bigram {
+			uint32_t rank{};
+			int32_t left{};
+			int32_t right{};
+			token_type left_id{};
+			token_type right_id{};
+			token_type result{};
+
+			NIHILUS_FORCE_INLINE bool operator<(const bigram& other) const noexcept {
+				return rank > other.rank || (rank == other.rank && left > other.left);
+			}
+		};
+
+		static constexpr uint64_t short_word_length{ 32 };
+		std::vector<std::string_view> tokens{};
+		token_text_table text_table{};
+		bpe_merge_table merge_table{};
+		array<token_type, 256> byte_symbols{};
+		// Symbols past the vocabulary (merge results without a token of their own) fall back to the tokens of their individual bytes.
+		std::vector<uint64_t> fallback_offsets{};
+		std::vector<token_type> fallback_tokens{};
+		std::vector<special_token> special_tokens{};
+		array<uint8_t, 256> special_first_bytes{};
+		token_type bos_token_id{ invalid_token };
+		bool ignore_merges{};
+		std::string sanitized_text{};
+		std::string encoded_word{};
+		std::vector<symbol> symbols{};
+		std::vector<bigram> queue{};
+		std::vector<special_match> special_matches{};
+		std::vector<uint8_t> claimed{};
+		std::vector<uint64_t> last_match_end{};
+		std::vector<token_type> token_scratch{};
+		std::vector<uint32_t> piece_offsets{};
+		std::vector<uint8_t> piece_is_special{};
+		std::string piece_bytes{};
+		uint64_t max_piece_size{};
+		tokenization_cache* cache{};
+		std::vector<uint64_t> prefix_hashes{};
+		std::vector<uint64_t> prefix_lengths{};
+
+		NIHILUS_FORCE_INLINE static uint64_t encode_byte(uint8_t byte, char* output) noexcept {
+			return encode_utf8(byte_to_code_point[byte], output);
+		}
+
+		NIHILUS_FORCE_INLINE void init_symbols(const std::vector<std::string_view>& merges) {
+			fallback_offsets.assign(1, 0);
+			fallback_tokens.clear();
+			std::unordered_map<std::string, token_type> extra_symbols{};
+			const auto get_symbol = [&](std::string_view text) -> token_type {
+				const token_type id = text_table.find(tokens, text);
+				if (id != invalid_token) {
+					return id;
+				}
+				const auto [iter, inserted] = extra_symbols.try_emplace(std::string{ text }, static_cast<token_type>(tokens.size() + extra_symbols.size()));
+				if (inserted) {
+					for (uint64_t x = 0; x < text.size();) {
+						const uint64_t length = std::min<uint64_t>(decode_utf8(text.data() + x, text.size() - x).length, text.size() - x);
+						const token_type byte_id = text_table.find(tokens, text.substr(x, length));
+						if (byte_id != invalid_token) {
+							fallback_tokens.emplace_back(byte_id);
+						}
+						x += length;
+					}
+					fallback_offsets.emplace_back(fallback_tokens.size());
+				}
+				return iter->second;
+			};
+			for (uint64_t x = 0; x < 256; ++x) {
+				char buffer[4]{};
+				byte_symbols[x] = get_symbol(std::string_view{ buffer, encode_byte(static_cast<uint8_t>(x), buffer) });
+			}
+			merge_table.init(merges.size());
+			std::string merged{};
+			for (uint64_t x = 0; x < merges.size(); ++x) {
+				const uint64_t split = merges[x].find(' ', 1);
+				if (split == std::string_view::npos) {
+					continue;
+				}
+				const std::string_view left{ merges[x].substr(0, split) };
+				const std::string_view right{ merges[x].substr(split + 1) };
+				merged.assign(left).append(right);
+				const token_type left_id  = get_symbol(left);
+				const token_type right_id = get_symbol(right);
+				merge_table.insert(left_id, right_id, static_cast<uint32_t>(x), get_symbol(merged));
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void init_special_tokens(const std::vector<int64_t>& token_types) {
+			special_tokens.clear();
+			special_first_bytes = {};
+			for (uint64_t x = 0; x < token_types.size() && x < tokens.size(); ++x) {
+				const token_attribute attribute{ static_cast<token_attribute>(token_types[x]) };
+				if ((attribute == token_attribute::control || attribute == token_attribute::user_defined || attribute == token_attribute::unknown) && !tokens[x].empty()) {
+					special_tokens.emplace_back(special_token{ static_cast<token_type>(x), attribute != token_attribute::user_defined });
+					special_first_bytes[static_cast<uint8_t>(tokens[x].front())] = 1;
+				}
+			}
+			std::stable_sort(special_tokens.begin(), special_tokens.end(), [&](const special_token& lhs, const special_token& rhs) {
+				return tokens[static_cast<uint64_t>(lhs.id)].size() > tokens[static_cast<uint64_t>(rhs.id)].size();
+			});
+			last_match_end.assign(special_tokens.size(), 0);
+		}
+
+		// Hashes of the prefixes that end after each special match, chained segment by segment so the whole text is hashed once. The tokenize flags
+		// seed the chain, since the same text splits differently with and without parse_special.
+		NIHILUS_FORCE_INLINE void get_prefix_hashes(std::string_view text, const std::vector<special_match>& matches, uint32_t flags) {
+			prefix_hashes.resize(matches.size());
+			prefix_lengths.resize(matches.size());
+			uint64_t hash{ hash_bytes(reinterpret_cast<const uint8_t*>(&flags), sizeof(flags)) };
+			uint64_t position{};
+			for (uint64_t x = 0; x < matches.size(); ++x) {
+				const uint64_t end = matches[x].offset + tokens[static_cast<uint64_t>(special_tokens[matches[x].special_index].id)].size();
+				hash			   = hash_bytes(reinterpret_cast<const uint8_t*>(text.data()) + position, end - position, hash);
+				prefix_hashes[x]   = hash;
+				prefix_lengths[x]  = end;
+				position		   = end;
+			}
+		}
+
+		// Flattens the byte-level decoding of every token into one buffer, so detokenizing is a table lookup. A code point that does not stand for a
+		// byte is copied through as UTF-8.
+		NIHILUS_FORCE_INLINE void init_pieces(const std::vector<int64_t>& token_types) {
+			piece_offsets.assign(1, 0);
+			piece_is_special.assign(tokens.size(), 0);
+			piece_bytes.clear();
+			max_piece_size = 0;
+			for (uint64_t x = 0; x < tokens.size(); ++x) {
+				const token_attribute attribute{ x < token_types.size() ? static_cast<token_attribute>(token_types[x]) : token_attribute::normal };
+				if (attribute == token_attribute::control || attribute == token_attribute::unknown || attribute == token_attribute::user_defined) {
+					piece_is_special[x] = attribute != token_attribute::user_defined;
+					piece_bytes.append(tokens[x]);
+				} else {
+					for (uint64_t y = 0; y < tokens[x].size();) {
+						const utf8_code_point code_point = decode_utf8(tokens[x].data() + y, tokens[x].size() - y);
+						if (code_point.valid && code_point.value < byte_code_point_limit && code_point_to_byte[code_point.value] >= 0) {
+							piece_bytes.push_back(static_cast<char>(code_point_to_byte[code_point.value]));
+						} else {
+							piece_bytes.append(tokens[x].substr(y, code_point.length));
+						}
+						y += code_point.length;
+					}
+				}
+				max_piece_size = std::max<uint64_t>(max_piece_size, piece_bytes.size() - piece_offsets.back());
+				piece_offsets.emplace_back(static_cast<uint32_t>(piece_bytes.size()));
+			}
+		}
+
+		// Invalid UTF-8 is replaced byte by byte with U+FFFD, which is what the reference tokenizer sees after its code point conversion.
+		NIHILUS_FORCE_INLINE std::string_view sanitize_utf8(std::string_view text) {
+			uint64_t x{};
+			while (x < text.size()) {
+				const utf8_code_point code_point = decode_utf8(text.data() + x, text.size() - x);
+				if (!code_point.valid) {
+					break;
+				}
+				x += code_point.length;
+			}
+			if (x == text.size()) {
+				return text;
+			}
+			sanitized_text.assign(text.substr(0, x));
+			while (x < text.size()) {
+				const utf8_code_point code_point = decode_utf8(text.data() + x, text.size() - x);
+				if (code_point.valid) {
+					sanitized_text.append(text.substr(x, code_point.length));
+				} else {
+					char buffer[4]{};
+					sanitized_text.append(buffer, encode_utf8(replacement_code_point, buffer));
+				}
+				x += code_point.length;
+			}
+			return sanitized_text;
+		}
+
+		// Matches the reference partitioning: the longest special token is split out everywhere first (left to right, non-overlapping), then the next
+		// longest within what remains, and so on. All candidate positions are found in one pass and then accepted in that order.
+		NIHILUS_FORCE_INLINE const std::vector<special_match>& find_special_tokens(std::string_view text, bool parse_special) {
+			special_matches.clear();
+			if (special_tokens.empty()) {
+				return special_matches;
+			}
+			for (uint64_t x = 0; x < text.size(); ++x) {
+				if (!special_first_bytes[static_cast<uint8_t>(text[x])]) {
+					continue;
+				}
+				for (uint64_t y = 0; y < special_tokens.size(); ++y) {
+					if ((parse_special || !special_tokens[y].control) && text.substr(x).starts_with(tokens[static_cast<uint64_t>(special_tokens[y].id)])) {
+						special_matches.emplace_back(special_match{ y, x });
+					}
+				}
+			}
+			if (special_matches.empty()) {
+				return special_matches;
+			}
+			std::sort(special_matches.begin(), special_matches.end(), [](const special_match& lhs, const special_match& rhs) {
+				return lhs.special_index < rhs.special_index || (lhs.special_index == rhs.special_index && lhs.offset < rhs.offset);
+			});
+			claimed.assign(text.size(), 0);
+			std::fill(last_match_end.begin(), last_match_end.end(), 0);
+			uint64_t accepted{};
+			for (const auto& match: special_matches) {
+				const uint64_t length = tokens[static_cast<uint64_t>(special_tokens[match.special_index].id)].size();
+				if (match.offset < last_match_end[match.special_index] ||
+					std::find(claimed.begin() + static_cast<int64_t>(match.offset), claimed.begin() + static_cast<int64_t>(match.offset + length), 1) !=
+						claimed.begin() + static_cast<int64_t>(match.offset + length)) {
+					continue;
+				}
+				std::fill(claimed.begin() + static_cast<int64_t>(match.offset), claimed.begin() + static_cast<int64_t>(match.offset + length), 1);
+				last_match_end[match.special_index] = match.offset + length;
+				special_matches[accepted++]			= match;
+			}
+			special_matches.resize(accepted);
+			std::sort(special_matches.begin(), special_matches.end(), [](const special_match& lhs, const special_match& rhs) {
+				return lhs.offset < rhs.offset;
+			});
+			return special_matches;
+		}
+
+		struct code_point_info {
+			uint32_t value{};
+			uint32_t length{};
+			unicode_class type{ unicode_class::end };
+		};
+
+		NIHILUS_FORCE_INLINE static code_point_info get_code_point(std::string_view text, uint64_t position) noexcept {
+			if (position >= text.size()) {
+				return {};
+			}
+			const utf8_code_point code_point = decode_utf8(text.data() + position, text.size() - position);
+			return { code_point.value, code_point.length, get_unicode_class(code_point.value) };
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr uint32_t to_lower_ascii(uint32_t value) noexcept {
+			return value >= 'A' && value <= 'Z' ? value + ('a' - 'A') : value;
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr bool is_newline(uint32_t value) noexcept {
+			return value == '\r' || value == '\n';
+		}
+
+		// Returns the end of the run of code points of the given class starting at position. ASCII is classified 32 bytes at a time; a non-ASCII byte
+		// drops to decoding that one code point and the scan carries on after it.
+		NIHILUS_FORCE_INLINE static uint64_t scan_run(std::string_view text, uint64_t position, unicode_class type) noexcept {
+			while (position < text.size()) {
+				if (position + ascii_block_size <= text.size()) {
+					const uint32_t matching = get_class_mask(classify_ascii_block(text.data() + position), type);
+					if (matching == ~0u) {
+						position += ascii_block_size;
+						continue;
+					}
+					position += static_cast<uint64_t>(std::countr_one(matching));
+				} else {
+					while (position < text.size() && static_cast<uint8_t>(text[position]) < 0x80 && ascii_classes[static_cast<uint8_t>(text[position])] == type) {
+						++position;
+					}
+				}
+				if (position >= text.size() || static_cast<uint8_t>(text[position]) < 0x80) {
+					break;
+				}
+				const code_point_info next = get_code_point(text, position);
+				if (next.type != type) {
+					break;
+				}
+				position += next.length;
+			}
+			return position;
+		}
+
+		// (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+
+		template<typename word_callback_type> NIHILUS_FORCE_INLINE static void split_words(std::string_view text, word_callback_type&& callback) {
+			uint64_t position{};
+			uint64_t start{};
+			const auto emit = [&](uint64_t end) {
+				if (end > start) {
+					callback(text.substr(start, end - start));
+				}
+				start = end;
+			};
+			while (position < text.size()) {
+				const code_point_info current = get_code_point(text, position);
+				if (current.value == '\'' && position + 1 < text.size()) {
+					const code_point_info next	= get_code_point(text, position + 1);
+					const uint32_t next_lower = to_lower_ascii(next.value);
+					if (next_lower == 's' || next_lower == 't' || next_lower == 'm' || next_lower == 'd') {
+						position += 1 + next.length;
+						emit(position);
+						continue;
+					}
+					const code_point_info next_next = get_code_point(text, position + 1 + next.length);
+					const uint32_t next_next_lower	= to_lower_ascii(next_next.value);
+					if (position + 1 + next.length < text.size() &&
+						((next_lower == 'r' && next_next_lower == 'e') || (next_lower == 'v' && next_next_lower == 'e') || (next_lower == 'l' && next_next_lower == 'l'))) {
+						position += 1 + next.length + next_next.length;
+						emit(position);
+						continue;
+					}
+				}
+				if (!is_newline(current.value) && current.type != unicode_class::number) {
+					if (current.type == unicode_class::letter || get_code_point(text, position + current.length).type == unicode_class::letter) {
+						position = scan_run(text, position + current.length, unicode_class::letter);
+						emit(position);
+						continue;
+					}
+				}
+				if (current.type == unicode_class::number) {
+					uint64_t digits{};
+					for (code_point_info next = current; next.type == unicode_class::number; next = get_code_point(text, position)) {
+						position += next.length;
+						if (++digits == 3) {
+							emit(position);
+							digits = 0;
+						}
+					}
+					emit(position);
+					continue;
+				}
+				const code_point_info punctuation = current.value == ' ' ? get_code_point(text, position + 1) : current;
+				if (punctuation.type == unicode_class::other) {
+					position = scan_run(text, position + (current.value == ' '), unicode_class::other);
+					while (position < text.size() && is_newline(static_cast<uint8_t>(text[position]))) {
+						++position;
+					}
+					emit(position);
+					continue;
+				}
+				if (current.type != unicode_class::whitespace) {
+					position += current.length;
+					emit(position);
+					continue;
+				}
+				// \r and \n are single bytes that never occur inside a multi-byte sequence, so the run can be searched bytewise from the back.
+				const uint64_t whitespace_end = scan_run(text, position + current.length, unicode_class::whitespace);
+				uint64_t last_newline_end{ whitespace_end };
+				while (last_newline_end > position && !is_newline(static_cast<uint8_t>(text[last_newline_end - 1]))) {
+					--last_newline_end;
+				}
+				uint64_t last_whitespace{ whitespace_end - 1 };
+				while ((static_cast<uint8_t>(text[last_whitespace]) & 0xC0) == 0x80) {
+					--last_whitespace;
+				}
+				if (last_newline_end > position) {
+					position = last_newline_end;
+				} else if (whitespace_end > position + current.length && whitespace_end < text.size()) {
+					position = last_whitespace;
+				} else {
+					position = whitespace_end;
+				}
+				emit(position);
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void tokenize_fragment(std::string_view fragment, std::vector<token_type>& output) {
+			split_words(fragment, [&](std::string_view word) {
+				tokenize_word(word, output);
+			});
+		}
+
+		NIHILUS_FORCE_INLINE void push_symbol(token_type id, std::vector<token_type>& output) {
+			if (static_cast<uint64_t>(id) < tokens.size()) {
+				output.emplace_back(id);
+				return;
+			}
+			const uint64_t extra = static_cast<uint64_t>(id) - tokens.size();
+			output.insert(output.end(), fallback_tokens.begin() + static_cast<int64_t>(fallback_offsets[extra]),
+				fallback_tokens.begin() + static_cast<int64_t>(fallback_offsets[extra + 1]));
+		}
+
+		NIHILUS_FORCE_INLINE void add_bigram(int32_t left, int32_t right) {
+			if (left < 0 || right < 0) {
+				return;
+			}
+			const token_type left_id  = symbols[static_cast<uint64_t>(left)].id;
+			const token_type right_id = symbols[static_cast<uint64_t>(right)].id;
+			if (const auto* merge = merge_table.find(left_id, right_id)) {
+				queue.emplace_back(bigram{ merge->rank, left, right, left_id, right_id, merge->result });
+				std::push_heap(queue.begin(), queue.end());
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void tokenize_word(std::string_view word, std::vector<token_type>& output) {
+			if (ignore_merges) {
+				encoded_word.clear();
+				for (char c: word) {
+					char buffer[4]{};
+					encoded_word.append(buffer, encode_byte(static_cast<uint8_t>(c), buffer));
+				}
+				if (const token_type id = text_table.find(tokens, encoded_word); id != invalid_token) {
+					output.emplace_back(id);
+					return;
+				}
+			}
+			if (word.size() <= short_word_length) {
+				merge_short_word(word, output);
+			} else {
+				merge_long_word(word, output);
+			}
+		}
+
+		// Most words are a handful of bytes, where rescanning the pair ranks for the minimum beats maintaining a heap. The pick is the same - lowest
+		// rank, leftmost on ties - so both paths produce identical merges.
+		NIHILUS_FORCE_INLINE void merge_short_word(std::string_view word, std::vector<token_type>& output) {
+			static constexpr uint32_t no_merge{ ~0u };
+			array<token_type, short_word_length> ids{};
+			array<uint32_t, short_word_length> ranks{};
+			array<token_type, short_word_length> results{};
+			uint64_t count = word.size();
+			const auto update_pair = [&](uint64_t index) {
+				const auto* merge = merge_table.find(ids[index], ids[index + 1]);
+				ranks[index]	  = merge ? merge->rank : no_merge;
+				results[index]	  = merge ? merge->result : invalid_token;
+			};
+			for (uint64_t x = 0; x < count; ++x) {
+				ids[x] = byte_symbols[static_cast<uint8_t>(word[x])];
+			}
+			for (uint64_t x = 0; x + 1 < count; ++x) {
+				update_pair(x);
+			}
+			while (count > 1) {
+				uint64_t best{};
+				for (uint64_t x = 1; x + 1 < count; ++x) {
+					best = ranks[x] < ranks[best] ? x : best;
+				}
+				if (ranks[best] == no_merge) {
+					break;
+				}
+				ids[best] = results[best];
+				for (uint64_t x = best + 1; x + 1 < count; ++x) {
+					ids[x]	   = ids[x + 1];
+					ranks[x]   = ranks[x + 1];
+					results[x] = results[x + 1];
+				}
+				--count;
+				if (best > 0) {
+					update_pair(best - 1);
+				}
+				if (best + 1 < count) {
+					update_pair(best);
+				}
+			}
+			for (uint64_t x = 0; x < count; ++x) {
+				push_symbol(ids[x], output);
+			}
+		}
+
+		NIHILUS_FORCE_INLINE void merge_long_word(std::string_view word, std::vector<token_type>& output) {
+			symbols.clear();
+			queue.clear();
+			for (uint64_t x = 0; x < word.size(); ++x) {
+				symbols.emplace_back(symbol{ byte_symbols[static_cast<uint8_t>(word[x])], static_cast<int32_t>(x) - 1,
+					x + 1 < word.size() ? static_cast<int32_t>(x + 1) : -1 });
+			}
+			for (uint64_t x = 1; x < symbols.size(); ++x) {
+				add_bigram(static_cast<int32_t>(x - 1), static_cast<int32_t>(x));
+			}
+			while (!queue.empty()) {
+				std::pop_heap(queue.begin(), queue.end());
+				const bigram top = queue.back();
+				queue.pop_back();
+				symbol& left  = symbols[static_cast<uint64_t>(top.left)];
+				symbol& right = symbols[static_cast<uint64_t>(top.right)];
+				if (left.id != top.left_id || right.id != top.right_id) {
+					continue;
+				}
+				left.id	   = top.result;
+				right.id   = invalid_token;
+				left.next  = right.next;
+				if (right.next >= 0) {
+					symbols[static_cast<uint64_t>(right.next)].prev = top.left;
+				}
+				add_bigram(left.prev, top.left);
+				add_bigram(top.left, left.next);
+			}
+			for (int32_t x = symbols.empty() ? -1 : 0; x >= 0; x = symbols[static_cast<uint64_t>(x)].next) {
+				push_symbol(symbols[static_cast<uint64_t>(x)].id, output);
+			}
+		}
+	};
 
 }
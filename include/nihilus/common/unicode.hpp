@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+
+#pragma once
+
+#include <nihilus/common/config.hpp>
+#include <nihilus/common/array.hpp>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+
+namespace nihilus {
+
+	// end doubles as "no flags at all", which is also what code points past U+10FFFF get.
+	enum class unicode_class : uint8_t {
+		other,
+		letter,
+		number,
+		whitespace,
+		end,
+	};
+
+	// Start of every run of code points sharing a general category class (L -> letter, N -> number, everything else -> other), packed as
+	// (first_code_point << 2) | class and generated from the Unicode Character Database.
+	static constexpr array<uint32_t, 1516> unicode_class_runs{ {
+		0x00000000, 0x000000C2, 0x000000E8, 0x00000105, 0x0000016C, 0x00000185, 0x000001EC, 0x000002A9, 0x000002AC, 0x000002CA,
+		0x000002D0, 0x000002D5, 0x000002D8, 0x000002E6, 0x000002E9, 0x000002EC, 0x000002F2, 0x000002FC, 0x00000301, 0x0000035C,
+		0x00000361, 0x000003DC, 0x000003E1, 0x00000B08, 0x00000B19, 0x00000B48, 0x00000B81, 0x00000B94, 0x00000BB1, 0x00000BB4,
+		0x00000BB9, 0x00000BBC, 0x00000DC1, 0x00000DD4, 0x00000DD9, 0x00000DE0, 0x00000DE9, 0x00000DF8, 0x00000DFD, 0x00000E00,
+		0x00000E19, 0x00000E1C, 0x00000E21, 0x00000E2C, 0x00000E31, 0x00000E34, 0x00000E39, 0x00000E88, 0x00000E8D, 0x00000FD8,
+		0x00000FDD, 0x00001208, 0x00001229, 0x000014C0, 0x000014C5, 0x0000155C, 0x00001565, 0x00001568, 0x00001581, 0x00001624,
+		0x00001741, 0x000017AC, 0x000017BD, 0x000017CC, 0x00001881, 0x0000192C, 0x00001982, 0x000019A8, 0x000019B9, 0x000019C0,
+		0x000019C5, 0x00001B50, 0x00001B55, 0x00001B58, 0x00001B95, 0x00001B9C, 0x00001BB9, 0x00001BC2, 0x00001BE9, 0x00001BF4,
+		0x00001BFD, 0x00001C00, 0x00001C41, 0x00001C44, 0x00001C49, 0x00001CC0, 0x00001D35, 0x00001E98, 0x00001EC5, 0x00001EC8,
+		0x00001F02, 0x00001F29, 0x00001FAC, 0x00001FD1, 0x00001FD8, 0x00001FE9, 0x00001FEC, 0x00002001, 0x00002058, 0x00002069,
+		0x0000206C, 0x00002091, 0x00002094, 0x000020A1, 0x000020A4, 0x00002101, 0x00002164, 0x00002181, 0x000021AC, 0x000021C1,
+		0x00002220, 0x00002225, 0x0000223C, 0x00002281, 0x00002328, 0x00002411, 0x000024E8, 0x000024F5, 0x000024F8, 0x00002541,
+		0x00002544, 0x00002561, 0x00002588, 0x0000259A, 0x000025C0, 0x000025C5, 0x00002604, 0x00002615, 0x00002634, 0x0000263D,
+		0x00002644, 0x0000264D, 0x000026A4, 0x000026A9, 0x000026C4, 0x000026C9, 0x000026CC, 0x000026D9, 0x000026E8, 0x000026F5,
+		0x000026F8, 0x00002739, 0x0000273C, 0x00002771, 0x00002778, 0x0000277D, 0x00002788, 0x0000279A, 0x000027C1, 0x000027C8,
+		0x000027D2, 0x000027E8, 0x000027F1, 0x000027F4, 0x00002815, 0x0000282C, 0x0000283D, 0x00002844, 0x0000284D, 0x000028A4,
+		0x000028A9, 0x000028C4, 0x000028C9, 0x000028D0, 0x000028D5, 0x000028DC, 0x000028E1, 0x000028E8, 0x00002965, 0x00002974,
+		0x00002979, 0x0000297C, 0x0000299A, 0x000029C0, 0x000029C9, 0x000029D4, 0x00002A15, 0x00002A38, 0x00002A3D, 0x00002A48,
+		0x00002A4D, 0x00002AA4, 0x00002AA9, 0x00002AC4, 0x00002AC9, 0x00002AD0, 0x00002AD5, 0x00002AE8, 0x00002AF5, 0x00002AF8,
+		0x00002B41, 0x00002B44, 0x00002B81, 0x00002B88, 0x00002B9A, 0x00002BC0, 0x00002BE5, 0x00002BE8, 0x00002C15, 0x00002C34,
+		0x00002C3D, 0x00002C44, 0x00002C4D, 0x00002CA4, 0x00002CA9, 0x00002CC4, 0x00002CC9, 0x00002CD0, 0x00002CD5, 0x00002CE8,
+		0x00002CF5, 0x00002CF8, 0x00002D71, 0x00002D78, 0x00002D7D, 0x00002D88, 0x00002D9A, 0x00002DC0, 0x00002DC5, 0x00002DCA,
+		0x00002DE0, 0x00002E0D, 0x00002E10, 0x00002E15, 0x00002E2C, 0x00002E39, 0x00002E44, 0x00002E49, 0x00002E58, 0x00002E65,
+		0x00002E6C, 0x00002E71, 0x00002E74, 0x00002E79, 0x00002E80, 0x00002E8D, 0x00002E94, 0x00002EA1, 0x00002EAC, 0x00002EB9,
+		0x00002EE8, 0x00002F41, 0x00002F44, 0x00002F9A, 0x00002FCC, 0x00003015, 0x00003034, 0x00003039, 0x00003044, 0x00003049,
+		0x000030A4, 0x000030A9, 0x000030E8, 0x000030F5, 0x000030F8, 0x00003161, 0x0000316C, 0x00003175, 0x00003178, 0x00003181,
+		0x00003188, 0x0000319A, 0x000031C0, 0x000031E2, 0x000031FC, 0x00003201, 0x00003204, 0x00003215, 0x00003234, 0x00003239,
+		0x00003244, 0x00003249, 0x000032A4, 0x000032A9, 0x000032D0, 0x000032D5, 0x000032E8, 0x000032F5, 0x000032F8, 0x00003375,
+		0x0000337C, 0x00003381, 0x00003388, 0x0000339A, 0x000033C0, 0x000033C5, 0x000033CC, 0x00003411, 0x00003434, 0x00003439,
+		0x00003444, 0x00003449, 0x000034EC, 0x000034F5, 0x000034F8, 0x00003539, 0x0000353C, 0x00003551, 0x0000355C, 0x00003562,
+		0x0000357D, 0x00003588, 0x0000359A, 0x000035E4, 0x000035E9, 0x00003600, 0x00003615, 0x0000365C, 0x00003669, 0x000036C8,
+		0x000036CD, 0x000036F0, 0x000036F5, 0x000036F8, 0x00003701, 0x0000371C, 0x0000379A, 0x000037C0, 0x00003805, 0x000038C4,
+		0x000038C9, 0x000038D0, 0x00003901, 0x0000391C, 0x00003942, 0x00003968, 0x00003A05, 0x00003A0C, 0x00003A11, 0x00003A14,
+		0x00003A19, 0x00003A2C, 0x00003A31, 0x00003A90, 0x00003A95, 0x00003A98, 0x00003A9D, 0x00003AC4, 0x00003AC9, 0x00003AD0,
+		0x00003AF5, 0x00003AF8, 0x00003B01, 0x00003B14, 0x00003B19, 0x00003B1C, 0x00003B42, 0x00003B68, 0x00003B71, 0x00003B80,
+		0x00003C01, 0x00003C04, 0x00003C82, 0x00003CD0, 0x00003D01, 0x00003D20, 0x00003D25, 0x00003DB4, 0x00003E21, 0x00003E34,
+		0x00004001, 0x000040AC, 0x000040FD, 0x00004102, 0x00004128, 0x00004141, 0x00004158, 0x00004169, 0x00004178, 0x00004185,
+		0x00004188, 0x00004195, 0x0000419C, 0x000041B9, 0x000041C4, 0x000041D5, 0x00004208, 0x00004239, 0x0000423C, 0x00004242,
+		0x00004268, 0x00004281, 0x00004318, 0x0000431D, 0x00004320, 0x00004335, 0x00004338, 0x00004341, 0x000043EC, 0x000043F1,
+		0x00004924, 0x00004929, 0x00004938, 0x00004941, 0x0000495C, 0x00004961, 0x00004964, 0x00004969, 0x00004978, 0x00004981,
+		0x00004A24, 0x00004A29, 0x00004A38, 0x00004A41, 0x00004AC4, 0x00004AC9, 0x00004AD8, 0x00004AE1, 0x00004AFC, 0x00004B01,
+		0x00004B04, 0x00004B09, 0x00004B18, 0x00004B21, 0x00004B5C, 0x00004B61, 0x00004C44, 0x00004C49, 0x00004C58, 0x00004C61,
+		0x00004D6C, 0x00004DA6, 0x00004DF4, 0x00004E01, 0x00004E40, 0x00004E81, 0x00004FD8, 0x00004FE1, 0x00004FF8, 0x00005005,
+		0x000059B4, 0x000059BD, 0x00005A00, 0x00005A05, 0x00005A6C, 0x00005A81, 0x00005BAC, 0x00005BBA, 0x00005BC5, 0x00005BE4,
+		0x00005C01, 0x00005C48, 0x00005C7D, 0x00005CC8, 0x00005D01, 0x00005D48, 0x00005D81, 0x00005DB4, 0x00005DB9, 0x00005DC4,
+		0x00005E01, 0x00005ED0, 0x00005F5D, 0x00005F60, 0x00005F71, 0x00005F74, 0x00005F82, 0x00005FA8, 0x00005FC2, 0x00005FE8,
+		0x00006042, 0x00006068, 0x00006081, 0x000061E4, 0x00006201, 0x00006214, 0x0000621D, 0x000062A4, 0x000062A9, 0x000062AC,
+		0x000062C1, 0x000063D8, 0x00006401, 0x0000647C, 0x0000651A, 0x00006541, 0x000065B8, 0x000065C1, 0x000065D4, 0x00006601,
+		0x000066B0, 0x000066C1, 0x00006728, 0x00006742, 0x0000676C, 0x00006801, 0x0000685C, 0x00006881, 0x00006954, 0x00006A02,
+		0x00006A28, 0x00006A42, 0x00006A68, 0x00006A9D, 0x00006AA0, 0x00006C15, 0x00006CD0, 0x00006D15, 0x00006D34, 0x00006D42,
+		0x00006D68, 0x00006E0D, 0x00006E84, 0x00006EB9, 0x00006EC2, 0x00006EE9, 0x00006F98, 0x00007001, 0x00007090, 0x00007102,
+		0x00007128, 0x00007135, 0x00007142, 0x00007169, 0x000071F8, 0x00007201, 0x00007224, 0x00007241, 0x000072EC, 0x000072F5,
+		0x00007300, 0x000073A5, 0x000073B4, 0x000073B9, 0x000073D0, 0x000073D5, 0x000073DC, 0x000073E9, 0x000073EC, 0x00007401,
+		0x00007700, 0x00007801, 0x00007C58, 0x00007C61, 0x00007C78, 0x00007C81, 0x00007D18, 0x00007D21, 0x00007D38, 0x00007D41,
+		0x00007D60, 0x00007D65, 0x00007D68, 0x00007D6D, 0x00007D70, 0x00007D75, 0x00007D78, 0x00007D7D, 0x00007DF8, 0x00007E01,
+		0x00007ED4, 0x00007ED9, 0x00007EF4, 0x00007EF9, 0x00007EFC, 0x00007F09, 0x00007F14, 0x00007F19, 0x00007F34, 0x00007F41,
+		0x00007F50, 0x00007F59, 0x00007F70, 0x00007F81, 0x00007FB4, 0x00007FC9, 0x00007FD4, 0x00007FD9, 0x00007FF4, 0x000081C2,
+		0x000081C5, 0x000081C8, 0x000081D2, 0x000081E8, 0x000081FD, 0x00008202, 0x00008228, 0x00008241, 0x00008274, 0x00008409,
+		0x0000840C, 0x0000841D, 0x00008420, 0x00008429, 0x00008450, 0x00008455, 0x00008458, 0x00008465, 0x00008478, 0x00008491,
+		0x00008494, 0x00008499, 0x0000849C, 0x000084A1, 0x000084A4, 0x000084A9, 0x000084B8, 0x000084BD, 0x000084E8, 0x000084F1,
+		0x00008500, 0x00008515, 0x00008528, 0x00008539, 0x0000853C, 0x00008542, 0x0000860D, 0x00008616, 0x00008628, 0x00009182,
+		0x00009270, 0x000093AA, 0x00009400, 0x00009DDA, 0x00009E50, 0x0000B001, 0x0000B394, 0x0000B3AD, 0x0000B3BC, 0x0000B3C9,
+		0x0000B3D0, 0x0000B3F6, 0x0000B3F8, 0x0000B401, 0x0000B498, 0x0000B49D, 0x0000B4A0, 0x0000B4B5, 0x0000B4B8, 0x0000B4C1,
+		0x0000B5A0, 0x0000B5BD, 0x0000B5C0, 0x0000B601, 0x0000B65C, 0x0000B681, 0x0000B69C, 0x0000B6A1, 0x0000B6BC, 0x0000B6C1,
+		0x0000B6DC, 0x0000B6E1, 0x0000B6FC, 0x0000B701, 0x0000B71C, 0x0000B721, 0x0000B73C, 0x0000B741, 0x0000B75C, 0x0000B761,
+		0x0000B77C, 0x0000B8BD, 0x0000B8C0, 0x0000C015, 0x0000C01E, 0x0000C020, 0x0000C086, 0x0000C0A8, 0x0000C0C5, 0x0000C0D8,
+		0x0000C0E2, 0x0000C0ED, 0x0000C0F4, 0x0000C105, 0x0000C25C, 0x0000C275, 0x0000C280, 0x0000C285, 0x0000C3EC, 0x0000C3F1,
+		0x0000C400, 0x0000C415, 0x0000C4C0, 0x0000C4C5, 0x0000C63C, 0x0000C64A, 0x0000C658, 0x0000C681, 0x0000C700, 0x0000C7C1,
+		0x0000C800, 0x0000C882, 0x0000C8A8, 0x0000C922, 0x0000C940, 0x0000C946, 0x0000C980, 0x0000CA02, 0x0000CA28, 0x0000CAC6,
+		0x0000CB00, 0x0000D001, 0x00013700, 0x00013801, 0x00029234, 0x00029341, 0x000293F8, 0x00029401, 0x00029834, 0x00029841,
+		0x00029882, 0x000298A9, 0x000298B0, 0x00029901, 0x000299BC, 0x000299FD, 0x00029A78, 0x00029A81, 0x00029B9A, 0x00029BC0,
+		0x00029C5D, 0x00029C80, 0x00029C89, 0x00029E24, 0x00029E2D, 0x00029F2C, 0x00029F41, 0x00029F48, 0x00029F4D, 0x00029F50,
+		0x00029F55, 0x00029F68, 0x00029FC9, 0x0002A008, 0x0002A00D, 0x0002A018, 0x0002A01D, 0x0002A02C, 0x0002A031, 0x0002A08C,
+		0x0002A0C2, 0x0002A0D8, 0x0002A101, 0x0002A1D0, 0x0002A209, 0x0002A2D0, 0x0002A342, 0x0002A368, 0x0002A3C9, 0x0002A3E0,
+		0x0002A3ED, 0x0002A3F0, 0x0002A3F5, 0x0002A3FC, 0x0002A402, 0x0002A429, 0x0002A498, 0x0002A4C1, 0x0002A51C, 0x0002A581,
+		0x0002A5F4, 0x0002A611, 0x0002A6CC, 0x0002A73D, 0x0002A742, 0x0002A768, 0x0002A781, 0x0002A794, 0x0002A799, 0x0002A7C2,
+		0x0002A7E9, 0x0002A7FC, 0x0002A801, 0x0002A8A4, 0x0002A901, 0x0002A90C, 0x0002A911, 0x0002A930, 0x0002A942, 0x0002A968,
+		0x0002A981, 0x0002A9DC, 0x0002A9E9, 0x0002A9EC, 0x0002A9F9, 0x0002AAC0, 0x0002AAC5, 0x0002AAC8, 0x0002AAD5, 0x0002AADC,
+		0x0002AAE5, 0x0002AAF8, 0x0002AB01, 0x0002AB04, 0x0002AB09, 0x0002AB0C, 0x0002AB6D, 0x0002AB78, 0x0002AB81, 0x0002ABAC,
+		0x0002ABC9, 0x0002ABD4, 0x0002AC05, 0x0002AC1C, 0x0002AC25, 0x0002AC3C, 0x0002AC45, 0x0002AC5C, 0x0002AC81, 0x0002AC9C,
+		0x0002ACA1, 0x0002ACBC, 0x0002ACC1, 0x0002AD6C, 0x0002AD71, 0x0002ADA8, 0x0002ADC1, 0x0002AF8C, 0x0002AFC2, 0x0002AFE8,
+		0x0002B001, 0x00035E90, 0x00035EC1, 0x00035F1C, 0x00035F2D, 0x00035FF0, 0x0003E401, 0x0003E9B8, 0x0003E9C1, 0x0003EB68,
+		0x0003EC01, 0x0003EC1C, 0x0003EC4D, 0x0003EC60, 0x0003EC75, 0x0003EC78, 0x0003EC7D, 0x0003ECA4, 0x0003ECA9, 0x0003ECDC,
+		0x0003ECE1, 0x0003ECF4, 0x0003ECF9, 0x0003ECFC, 0x0003ED01, 0x0003ED08, 0x0003ED0D, 0x0003ED14, 0x0003ED19, 0x0003EEC8,
+		0x0003EF4D, 0x0003F4F8, 0x0003F541, 0x0003F640, 0x0003F649, 0x0003F720, 0x0003F7C1, 0x0003F7F0, 0x0003F9C1, 0x0003F9D4,
+		0x0003F9D9, 0x0003FBF4, 0x0003FC42, 0x0003FC68, 0x0003FC85, 0x0003FCEC, 0x0003FD05, 0x0003FD6C, 0x0003FD99, 0x0003FEFC,
+		0x0003FF09, 0x0003FF20, 0x0003FF29, 0x0003FF40, 0x0003FF49, 0x0003FF60, 0x0003FF69, 0x0003FF74, 0x00040001, 0x00040030,
+		0x00040035, 0x0004009C, 0x000400A1, 0x000400EC, 0x000400F1, 0x000400F8, 0x000400FD, 0x00040138, 0x00040141, 0x00040178,
+		0x00040201, 0x000403EC, 0x0004041E, 0x000404D0, 0x00040502, 0x000405E4, 0x0004062A, 0x00040630, 0x00040A01, 0x00040A74,
+		0x00040A81, 0x00040B44, 0x00040B86, 0x00040BF0, 0x00040C01, 0x00040C82, 0x00040C90, 0x00040CB5, 0x00040D06, 0x00040D09,
+		0x00040D2A, 0x00040D2C, 0x00040D41, 0x00040DD8, 0x00040E01, 0x00040E78, 0x00040E81, 0x00040F10, 0x00040F21, 0x00040F40,
+		0x00040F46, 0x00040F58, 0x00041001, 0x00041278, 0x00041282, 0x000412A8, 0x000412C1, 0x00041350, 0x00041361, 0x000413F0,
+		0x00041401, 0x000414A0, 0x000414C1, 0x00041590, 0x000415C1, 0x000415EC, 0x000415F1, 0x0004162C, 0x00041631, 0x0004164C,
+		0x00041651, 0x00041658, 0x0004165D, 0x00041688, 0x0004168D, 0x000416C8, 0x000416CD, 0x000416E8, 0x000416ED, 0x000416F4,
+		0x00041801, 0x00041CDC, 0x00041D01, 0x00041D58, 0x00041D81, 0x00041DA0, 0x00041E01, 0x00041E18, 0x00041E1D, 0x00041EC4,
+		0x00041EC9, 0x00041EEC, 0x00042001, 0x00042018, 0x00042021, 0x00042024, 0x00042029, 0x000420D8, 0x000420DD, 0x000420E4,
+		0x000420F1, 0x000420F4, 0x000420FD, 0x00042158, 0x00042162, 0x00042181, 0x000421DC, 0x000421E6, 0x00042201, 0x0004227C,
+		0x0004229E, 0x000422C0, 0x00042381, 0x000423CC, 0x000423D1, 0x000423D8, 0x000423EE, 0x00042401, 0x0004245A, 0x00042470,
+		0x00042481, 0x000424E8, 0x00042601, 0x000426E0, 0x000426F2, 0x000426F9, 0x00042702, 0x00042740, 0x0004274A, 0x00042801,
+		0x00042804, 0x00042841, 0x00042850, 0x00042855, 0x00042860, 0x00042865, 0x000428D8, 0x00042902, 0x00042924, 0x00042981,
+		0x000429F6, 0x000429FC, 0x00042A01, 0x00042A76, 0x00042A80, 0x00042B01, 0x00042B20, 0x00042B25, 0x00042B94, 0x00042BAE,
+		0x00042BC0, 0x00042C01, 0x00042CD8, 0x00042D01, 0x00042D58, 0x00042D62, 0x00042D81, 0x00042DCC, 0x00042DE2, 0x00042E01,
+		0x00042E48, 0x00042EA6, 0x00042EC0, 0x00043001, 0x00043124, 0x00043201, 0x000432CC, 0x00043301, 0x000433CC, 0x000433EA,
+		0x00043401, 0x00043490, 0x000434C2, 0x000434E8, 0x00043982, 0x000439FC, 0x00043A01, 0x00043AA8, 0x00043AC1, 0x00043AC8,
+		0x00043C01, 0x00043C76, 0x00043C9D, 0x00043CA0, 0x00043CC1, 0x00043D18, 0x00043D46, 0x00043D54, 0x00043DC1, 0x00043E08,
+		0x00043EC1, 0x00043F16, 0x00043F30, 0x00043F81, 0x00043FDC, 0x0004400D, 0x000440E0, 0x0004414A, 0x000441C0, 0x000441C5,
+		0x000441CC, 0x000441D5, 0x000441D8, 0x0004420D, 0x000442C0, 0x00044341, 0x000443A4, 0x000443C2, 0x000443E8, 0x0004440D,
+		0x0004449C, 0x000444DA, 0x00044500, 0x00044511, 0x00044514, 0x0004451D, 0x00044520, 0x00044541, 0x000445CC, 0x000445D9,
+		0x000445DC, 0x0004460D, 0x000446CC, 0x00044705, 0x00044714, 0x00044742, 0x00044769, 0x0004476C, 0x00044771, 0x00044774,
+		0x00044786, 0x000447D4, 0x00044801, 0x00044848, 0x0004484D, 0x000448B0, 0x00044A01, 0x00044A1C, 0x00044A21, 0x00044A24,
+		0x00044A29, 0x00044A38, 0x00044A3D, 0x00044A78, 0x00044A7D, 0x00044AA4, 0x00044AC1, 0x00044B7C, 0x00044BC2, 0x00044BE8,
+		0x00044C15, 0x00044C34, 0x00044C3D, 0x00044C44, 0x00044C4D, 0x00044CA4, 0x00044CA9, 0x00044CC4, 0x00044CC9, 0x00044CD0,
+		0x00044CD5, 0x00044CE8, 0x00044CF5, 0x00044CF8, 0x00044D41, 0x00044D44, 0x00044D75, 0x00044D88, 0x00045001, 0x000450D4,
+		0x0004511D, 0x0004512C, 0x00045142, 0x00045168, 0x0004517D, 0x00045188, 0x00045201, 0x000452C0, 0x00045311, 0x00045318,
+		0x0004531D, 0x00045320, 0x00045342, 0x00045368, 0x00045601, 0x000456BC, 0x00045761, 0x00045770, 0x00045801, 0x000458C0,
+		0x00045911, 0x00045914, 0x00045942, 0x00045968, 0x00045A01, 0x00045AAC, 0x00045AE1, 0x00045AE4, 0x00045B02, 0x00045B28,
+		0x00045C01, 0x00045C6C, 0x00045CC2, 0x00045CF0, 0x00045D01, 0x00045D1C, 0x00046001, 0x000460B0, 0x00046281, 0x00046382,
+		0x000463CC, 0x000463FD, 0x0004641C, 0x00046425, 0x00046428, 0x00046431, 0x00046450, 0x00046455, 0x0004645C, 0x00046461,
+		0x000464C0, 0x000464FD, 0x00046500, 0x00046505, 0x00046508, 0x00046542, 0x00046568, 0x00046681, 0x000466A0, 0x000466A9,
+		0x00046744, 0x00046785, 0x00046788, 0x0004678D, 0x00046790, 0x00046801, 0x00046804, 0x0004682D, 0x000468CC, 0x000468E9,
+		0x000468EC, 0x00046941, 0x00046944, 0x00046971, 0x00046A28, 0x00046A75, 0x00046A78, 0x00046AC1, 0x00046BE4, 0x00047001,
+		0x00047024, 0x00047029, 0x000470BC, 0x00047101, 0x00047104, 0x00047142, 0x000471B4, 0x000471C9, 0x00047240, 0x00047401,
+		0x0004741C, 0x00047421, 0x00047428, 0x0004742D, 0x000474C4, 0x00047519, 0x0004751C, 0x00047542, 0x00047568, 0x00047581,
+		0x00047598, 0x0004759D, 0x000475A4, 0x000475A9, 0x00047628, 0x00047661, 0x00047664, 0x00047682, 0x000476A8, 0x00047B81,
+		0x00047BCC, 0x00047EC1, 0x00047EC4, 0x00047F02, 0x00047F54, 0x00048001, 0x00048E68, 0x00049002, 0x000491BC, 0x00049201,
+		0x00049510, 0x0004BE41, 0x0004BFC4, 0x0004C001, 0x0004D0BC, 0x00051001, 0x0005191C, 0x0005A001, 0x0005A8E4, 0x0005A901,
+		0x0005A97C, 0x0005A982, 0x0005A9A8, 0x0005A9C1, 0x0005AAFC, 0x0005AB02, 0x0005AB28, 0x0005AB41, 0x0005ABB8, 0x0005AC01,
+		0x0005ACC0, 0x0005AD01, 0x0005AD10, 0x0005AD42, 0x0005AD68, 0x0005AD6E, 0x0005AD88, 0x0005AD8D, 0x0005ADE0, 0x0005ADF5,
+		0x0005AE40, 0x0005B901, 0x0005BA02, 0x0005BA5C, 0x0005BC01, 0x0005BD2C, 0x0005BD41, 0x0005BD44, 0x0005BE4D, 0x0005BE80,
+		0x0005BF81, 0x0005BF88, 0x0005BF8D, 0x0005BF90, 0x0005C001, 0x00061FE0, 0x00062001, 0x00063358, 0x00063401, 0x00063424,
+		0x0006BFC1, 0x0006BFD0, 0x0006BFD5, 0x0006BFF0, 0x0006BFF5, 0x0006BFFC, 0x0006C001, 0x0006C48C, 0x0006C541, 0x0006C54C,
+		0x0006C591, 0x0006C5A0, 0x0006C5C1, 0x0006CBF0, 0x0006F001, 0x0006F1AC, 0x0006F1C1, 0x0006F1F4, 0x0006F201, 0x0006F224,
+		0x0006F241, 0x0006F268, 0x00074B82, 0x00074BD0, 0x00074D82, 0x00074DE4, 0x00075001, 0x00075154, 0x00075159, 0x00075274,
+		0x00075279, 0x00075280, 0x00075289, 0x0007528C, 0x00075295, 0x0007529C, 0x000752A5, 0x000752B4, 0x000752B9, 0x000752E8,
+		0x000752ED, 0x000752F0, 0x000752F5, 0x00075310, 0x00075315, 0x00075418, 0x0007541D, 0x0007542C, 0x00075435, 0x00075454,
+		0x00075459, 0x00075474, 0x00075479, 0x000754E8, 0x000754ED, 0x000754FC, 0x00075501, 0x00075514, 0x00075519, 0x0007551C,
+		0x00075529, 0x00075544, 0x00075549, 0x00075A98, 0x00075AA1, 0x00075B04, 0x00075B09, 0x00075B6C, 0x00075B71, 0x00075BEC,
+		0x00075BF1, 0x00075C54, 0x00075C59, 0x00075CD4, 0x00075CD9, 0x00075D3C, 0x00075D41, 0x00075DBC, 0x00075DC1, 0x00075E24,
+		0x00075E29, 0x00075EA4, 0x00075EA9, 0x00075F0C, 0x00075F11, 0x00075F30, 0x00075F3A, 0x00076000, 0x00077C01, 0x00077C7C,
+		0x00078401, 0x000784B4, 0x000784DD, 0x000784F8, 0x00078502, 0x00078528, 0x00078539, 0x0007853C, 0x00078A41, 0x00078AB8,
+		0x00078B01, 0x00078BB0, 0x00078BC2, 0x00078BE8, 0x00079F81, 0x00079F9C, 0x00079FA1, 0x00079FB0, 0x00079FB5, 0x00079FBC,
+		0x00079FC1, 0x00079FFC, 0x0007A001, 0x0007A314, 0x0007A31E, 0x0007A340, 0x0007A401, 0x0007A510, 0x0007A52D, 0x0007A530,
+		0x0007A542, 0x0007A568, 0x0007B1C6, 0x0007B2B0, 0x0007B2B6, 0x0007B2C0, 0x0007B2C6, 0x0007B2D4, 0x0007B406, 0x0007B4B8,
+		0x0007B4BE, 0x0007B4F8, 0x0007B801, 0x0007B810, 0x0007B815, 0x0007B880, 0x0007B885, 0x0007B88C, 0x0007B891, 0x0007B894,
+		0x0007B89D, 0x0007B8A0, 0x0007B8A5, 0x0007B8CC, 0x0007B8D1, 0x0007B8E0, 0x0007B8E5, 0x0007B8E8, 0x0007B8ED, 0x0007B8F0,
+		0x0007B909, 0x0007B90C, 0x0007B91D, 0x0007B920, 0x0007B925, 0x0007B928, 0x0007B92D, 0x0007B930, 0x0007B935, 0x0007B940,
+		0x0007B945, 0x0007B94C, 0x0007B951, 0x0007B954, 0x0007B95D, 0x0007B960, 0x0007B965, 0x0007B968, 0x0007B96D, 0x0007B970,
+		0x0007B975, 0x0007B978, 0x0007B97D, 0x0007B980, 0x0007B985, 0x0007B98C, 0x0007B991, 0x0007B994, 0x0007B99D, 0x0007B9AC,
+		0x0007B9B1, 0x0007B9CC, 0x0007B9D1, 0x0007B9E0, 0x0007B9E5, 0x0007B9F4, 0x0007B9F9, 0x0007B9FC, 0x0007BA01, 0x0007BA28,
+		0x0007BA2D, 0x0007BA70, 0x0007BA85, 0x0007BA90, 0x0007BA95, 0x0007BAA8, 0x0007BAAD, 0x0007BAF0, 0x0007C402, 0x0007C434,
+		0x0007EFC2, 0x0007EFE8, 0x00080001, 0x000A9B80, 0x000A9C01, 0x000ADCE4, 0x000ADD01, 0x000AE078, 0x000AE081, 0x000B3A88,
+		0x000B3AC1, 0x000BAF84, 0x000BE001, 0x000BE878, 0x000C0001, 0x000C4D2C,
+	} };
+
+	NIHILUS_FORCE_INLINE constexpr bool is_unicode_whitespace(uint32_t code_point) noexcept {
+		return (code_point >= 0x09 && code_point <= 0x0D) || code_point == 0x20 || code_point == 0x85 || code_point == 0xA0 || code_point == 0x1680 ||
+			(code_point >= 0x2000 && code_point <= 0x200A) || code_point == 0x2028 || code_point == 0x2029 || code_point == 0x202F || code_point == 0x205F ||
+			code_point == 0x3000;
+	}
+
+	NIHILUS_FORCE_INLINE constexpr unicode_class get_unicode_class_slow(uint32_t code_point) noexcept {
+		if (is_unicode_whitespace(code_point)) {
+			return unicode_class::whitespace;
+		}
+		if (code_point > 0x10FFFF) {
+			return unicode_class::end;
+		}
+		const auto run = std::upper_bound(unicode_class_runs.data(), unicode_class_runs.data() + unicode_class_runs.size(), (code_point << 2) | 3u);
+		return static_cast<unicode_class>(*(run - 1) & 3u);
+	}
+
+	static constexpr array<unicode_class, 128> ascii_classes{ [] {
+		array<unicode_class, 128> return_value{};
+		for (uint32_t x = 0; x < 128; ++x) {
+			return_value[x] = get_unicode_class_slow(x);
+		}
+		return return_value;
+	}() };
+
+	NIHILUS_FORCE_INLINE constexpr unicode_class get_unicode_class(uint32_t code_point) noexcept {
+		return code_point < 128 ? ascii_classes[code_point] : get_unicode_class_slow(code_point);
+	}
+
+	static constexpr uint32_t replacement_code_point{ 0xFFFD };
+
+	struct utf8_code_point {
+		uint32_t value{};
+		uint32_t length{};
+		bool valid{};
+	};
+
+	// Only the lead/continuation bit patterns are checked (overlong forms and surrogates are accepted), matching how llama.cpp splits its input; an
+	// invalid or truncated sequence consumes a single byte.
+	NIHILUS_FORCE_INLINE constexpr utf8_code_point decode_utf8(const char* data, uint64_t size) noexcept {
+		const uint8_t lead = static_cast<uint8_t>(data[0]);
+		if (lead < 0x80) {
+			return { lead, 1, true };
+		}
+		const auto continuation = [&](uint64_t index) {
+			return index < size && (static_cast<uint8_t>(data[index]) & 0xC0) == 0x80;
+		};
+		if ((lead & 0xE0) == 0xC0 && continuation(1)) {
+			return { (lead & 0x1Fu) << 6 | (static_cast<uint8_t>(data[1]) & 0x3Fu), 2, true };
+		}
+		if ((lead & 0xF0) == 0xE0 && continuation(1) && continuation(2)) {
+			return { (lead & 0x0Fu) << 12 | (static_cast<uint8_t>(data[1]) & 0x3Fu) << 6 | (static_cast<uint8_t>(data[2]) & 0x3Fu), 3, true };
+		}
+		if ((lead & 0xF8) == 0xF0 && continuation(1) && continuation(2) && continuation(3)) {
+			return { (lead & 0x07u) << 18 | (static_cast<uint8_t>(data[1]) & 0x3Fu) << 12 | (static_cast<uint8_t>(data[2]) & 0x3Fu) << 6 |
+					(static_cast<uint8_t>(data[3]) & 0x3Fu),
+				4, true };
+		}
+		return { replacement_code_point, 1, false };
+	}
+
+	NIHILUS_FORCE_INLINE constexpr uint64_t encode_utf8(uint32_t code_point, char* output) noexcept {
+		if (code_point < 0x80) {
+			output[0] = static_cast<char>(code_point);
+			return 1;
+		}
+		if (code_point < 0x800) {
+			output[0] = static_cast<char>(0xC0 | (code_point >> 6));
+			output[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+			return 2;
+		}
+		if (code_point < 0x10000) {
+			output[0] = static_cast<char>(0xE0 | (code_point >> 12));
+			output[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			output[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+			return 3;
+		}
+		output[0] = static_cast<char>(0xF0 | (code_point >> 18));
+		output[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+		output[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+		output[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+		return 4;
+	}
+
+	// GPT-2 style byte-level encoding: printable bytes map to themselves and the rest to U+0100 upwards, so every byte is one visible code point.
+	static constexpr array<uint32_t, 256> byte_to_code_point{ [] {
+		array<uint32_t, 256> return_value{};
+		uint32_t next{ 256 };
+		for (uint32_t x = 0; x < 256; ++x) {
+			const bool printable = (x >= 0x21 && x <= 0x7E) || (x >= 0xA1 && x <= 0xAC) || (x >= 0xAE && x <= 0xFF);
+			return_value[x]		 = printable ? x : next++;
+		}
+		return return_value;
+	}() };
+
+	static constexpr uint32_t byte_code_point_limit{ 324 };
+
+	// Inverse of byte_to_code_point, -1 for code points that do not stand for a byte.
+	static constexpr array<int16_t, byte_code_point_limit> code_point_to_byte{ [] {
+		array<int16_t, byte_code_point_limit> return_value{};
+		for (uint32_t x = 0; x < byte_code_point_limit; ++x) {
+			return_value[x] = -1;
+		}
+		for (uint32_t x = 0; x < 256; ++x) {
+			return_value[byte_to_code_point[x]] = static_cast<int16_t>(x);
+		}
+		return return_value;
+	}() };
+
+	// Length of the trailing bytes of text that start a UTF-8 sequence but do not complete it; stray continuation bytes are not held back.
+	NIHILUS_FORCE_INLINE constexpr uint64_t get_incomplete_utf8_suffix(std::string_view text) noexcept {
+		for (uint64_t x = 1; x <= 3 && x <= text.size(); ++x) {
+			const uint8_t byte = static_cast<uint8_t>(text[text.size() - x]);
+			if ((byte & 0xC0) == 0x80) {
+				continue;
+			}
+			const uint64_t expected = (byte & 0xE0) == 0xC0 ? 2 : (byte & 0xF0) == 0xE0 ? 3 : (byte & 0xF8) == 0xF0 ? 4 : 1;
+			return expected > x ? x : 0;
+		}
+		return 0;
+	}
+
+}
@@ -0,0 +1,219 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/model_graph_data.hpp>
+#include <nihilus/common/model_parser.hpp>
+#include <nihilus/common/model_traits.hpp>
+#include <nihilus/common/common.hpp>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <string>
+
+namespace nihilus {
+
+	enum class weight_cache_source : uint32_t {
+		none,
+		model,
+		cache,
+	};
+
+	struct weight_cache_entry {
+		weight_cache_source source{};
+		uint32_t reserved{};
+		uint64_t offset{};
+	};
+
+	// Sidecar file that lets a restart skip GGUF parsing - it stores the resolved data[op][block] offsets into the model file plus the construction
+	// parameters, and is only trusted when the model's size, mtime and a hash of its header region still match. Weights that were repacked at load
+	// time (see weight_repacker) are stored in the payload section and mapped straight from the sidecar, so a restart skips the repack as well.
+	template<model_config config> struct weight_cache {
+		using model_traits_type = model_traits<config.arch, config.model_size, config.model_generation>;
+		using op_type_type		= typename model_traits_type::op_type_type;
+		using data_array_type	= array<array<void*, model_traits_type::block_count>, op_type_type::count>;
+		static constexpr uint64_t magic{ 0x454843414348494Eull };
+		static constexpr uint32_t version{ 3 };
+		static constexpr uint64_t payload_alignment{ 4096 };
+		static constexpr uint64_t op_count{ static_cast<uint64_t>(op_type_type::count) };
+		static constexpr uint64_t entry_count{ op_count * model_traits_type::block_count };
+		static_assert(std::is_trivially_copyable_v<construction_parameters<config.arch>>, "construction_parameters must be trivially copyable to be cached.");
+
+		struct header_type {
+			uint64_t magic{};
+			uint32_t version{};
+			uint32_t op_count{};
+			uint64_t block_count{};
+			uint64_t config_hash{};
+			uint64_t model_size{};
+			int64_t model_mtime{};
+			uint64_t model_hash{};
+			uint64_t hashed_bytes{};
+			uint64_t tensor_data_offset{};
+			uint64_t payload_offset{};
+			uint64_t payload_size{};
+			uint64_t packed_rows{};
+			construction_parameters<config.arch> cparams{};
+		};
+
+		NIHILUS_FORCE_INLINE static uint64_t get_config_hash() noexcept {
+			const array<uint64_t, 6> values{ { static_cast<uint64_t>(config.arch), static_cast<uint64_t>(config.model_size), static_cast<uint64_t>(config.model_generation),
+				static_cast<uint64_t>(config.kernel_profile), static_cast<uint64_t>(config.format), entry_count } };
+			return hash_bytes(reinterpret_cast<const uint8_t*>(values.data()), sizeof(uint64_t) * values.size());
+		}
+
+		NIHILUS_FORCE_INLINE static int64_t get_mtime(std::string_view model_path) {
+			std::error_code error{};
+			auto time = std::filesystem::last_write_time(std::filesystem::path{ model_path }, error);
+			return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+		}
+
+		NIHILUS_FORCE_INLINE bool load(std::string_view path, std::string_view model_path, memory_mapped_file& model_data, data_array_type& data,
+			model_graph_data<config>& graph_data, uint64_t packed_rows) {
+			cache_path = path;
+			std::error_code error{};
+			if (!std::filesystem::exists(cache_path, error)) {
+				return false;
+			}
+			try {
+				cache_file.init(cache_path);
+			} catch (const std::exception& exception) {
+				log<log_level::error>("weight_cache: failed to map " + cache_path + ": " + exception.what());
+				return false;
+			}
+			if (cache_file.size() < sizeof(header_type) + entry_count * sizeof(weight_cache_entry)) {
+				return reject("truncated sidecar");
+			}
+			header_type header{};
+			std::memcpy(&header, cache_file.data(), sizeof(header_type));
+			if (header.magic != magic || header.version != version || header.op_count != op_count || header.block_count != model_traits_type::block_count) {
+				return reject("format mismatch");
+			}
+			if (header.config_hash != get_config_hash()) {
+				return reject("built for a different model config");
+			}
+			if (header.packed_rows != packed_rows) {
+				return reject("built with a different weight layout");
+			}
+			if (header.payload_offset + header.payload_size > cache_file.size()) {
+				return reject("truncated payload");
+			}
+			if (header.model_size != model_data.size() || header.model_mtime != get_mtime(model_path)) {
+				return reject("model file size or mtime changed");
+			}
+			if (header.hashed_bytes > model_data.size() ||
+				header.model_hash != hash_bytes(static_cast<const uint8_t*>(model_data.data()), header.hashed_bytes)) {
+				return reject("model header hash changed");
+			}
+			const uint8_t* entries = static_cast<const uint8_t*>(cache_file.data()) + sizeof(header_type);
+			uint64_t mapped_count{};
+			for (uint64_t x = 0; x < op_count; ++x) {
+				for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+					weight_cache_entry entry{};
+					std::memcpy(&entry, entries + (x * model_traits_type::block_count + y) * sizeof(weight_cache_entry), sizeof(weight_cache_entry));
+					if (entry.source == weight_cache_source::model && entry.offset < model_data.size()) {
+						*static_cast<void**>(data[x][y]) = static_cast<uint8_t*>(model_data.data()) + entry.offset;
+						++mapped_count;
+					} else if (entry.source == weight_cache_source::cache && entry.offset < cache_file.size()) {
+						*static_cast<void**>(data[x][y]) = static_cast<uint8_t*>(cache_file.data()) + entry.offset;
+						++mapped_count;
+					}
+				}
+			}
+			graph_data.cparams			  = header.cparams;
+			graph_data.tensor_data_offset = header.tensor_data_offset;
+			log<log_level::status>("weight_cache: restored " + std::to_string(mapped_count) + " tensor pointers from " + cache_path);
+			return true;
+		}
+
+		// Pointers into the model mapping are recorded as model-relative offsets and pointers into [payload, payload + payload_size) are copied into the
+		// sidecar; anything else is left unresolved.
+		NIHILUS_FORCE_INLINE void save(std::string_view path, std::string_view model_path, const memory_mapped_file& model_data, const data_array_type& data,
+			const model_graph_data<config>& graph_data, const uint8_t* payload = nullptr, uint64_t payload_size = 0, uint64_t packed_rows = 0) {
+			cache_path = path;
+			header_type header{};
+			header.magic			  = magic;
+			header.version			  = version;
+			header.op_count			  = op_count;
+			header.block_count		  = model_traits_type::block_count;
+			header.config_hash		  = get_config_hash();
+			header.model_size		  = model_data.size();
+			header.model_mtime		  = get_mtime(model_path);
+			header.hashed_bytes		  = std::min<uint64_t>(graph_data.tensor_data_offset, model_data.size());
+			header.model_hash		  = hash_bytes(static_cast<const uint8_t*>(model_data.data()), header.hashed_bytes);
+			header.tensor_data_offset = graph_data.tensor_data_offset;
+			header.cparams			  = graph_data.cparams;
+			header.packed_rows		  = packed_rows;
+			header.payload_size		  = payload ? payload_size : 0;
+			header.payload_offset	  = header.payload_size > 0 ? round_up_to_multiple(sizeof(header_type) + entry_count * sizeof(weight_cache_entry), payload_alignment) : 0;
+			std::vector<uint8_t> buffer(sizeof(header_type) + entry_count * sizeof(weight_cache_entry));
+			std::memcpy(buffer.data(), &header, sizeof(header_type));
+			const uint8_t* model_begin = static_cast<const uint8_t*>(model_data.data());
+			const uint8_t* model_end   = model_begin + model_data.size();
+			for (uint64_t x = 0; x < op_count; ++x) {
+				for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+					weight_cache_entry entry{};
+					const uint8_t* ptr = data[x][y] ? *static_cast<uint8_t* const*>(data[x][y]) : nullptr;
+					if (ptr >= model_begin && ptr < model_end) {
+						entry.source = weight_cache_source::model;
+						entry.offset = static_cast<uint64_t>(ptr - model_begin);
+					} else if (header.payload_size > 0 && ptr >= payload && ptr < payload + header.payload_size) {
+						entry.source = weight_cache_source::cache;
+						entry.offset = header.payload_offset + static_cast<uint64_t>(ptr - payload);
+					}
+					std::memcpy(buffer.data() + sizeof(header_type) + (x * model_traits_type::block_count + y) * sizeof(weight_cache_entry), &entry, sizeof(entry));
+				}
+			}
+			const std::string temp_path{ cache_path + ".tmp" };
+			std::ofstream file{ temp_path, std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+			if (header.payload_size > 0) {
+				const std::vector<char> padding(header.payload_offset - buffer.size());
+				file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+				file.write(reinterpret_cast<const char*>(payload), static_cast<std::streamsize>(header.payload_size));
+			}
+			file.close();
+			std::error_code error{};
+			if (!file) {
+				log<log_level::error>("weight_cache: failed to write " + temp_path);
+				std::filesystem::remove(temp_path, error);
+				return;
+			}
+			std::filesystem::rename(temp_path, cache_path, error);
+			if (error) {
+				log<log_level::error>("weight_cache: failed to write " + cache_path + ": " + error.message());
+				return;
+			}
+			log<log_level::status>("weight_cache: wrote " + cache_path + " (" + std::to_string(header.payload_size / (1024ull * 1024ull)) + " MB of repacked weights)");
+		}
+
+	  protected:
+		memory_mapped_file cache_file{};
+		std::string cache_path{};
+
+		NIHILUS_FORCE_INLINE bool reject(std::string_view reason) {
+			log<log_level::status>("weight_cache: ignoring " + cache_path + " (" + std::string{ reason } + ")");
+			cache_file.deinit();
+			return false;
+		}
+	};
+
+}
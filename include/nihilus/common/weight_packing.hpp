@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/data_types.hpp>
+#include <nihilus/common/common.hpp>
+#include <nihilus/cpu/topology.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace nihilus {
+
+	// Interleaved q8_0 - rows are packed in groups of rows_per_group; each group holds the scales of all its blocks (block-major, one per row) in a
+	// separate 64-byte aligned run, followed by the quants of block 0 for every row of the group, then block 1, and so on. One kernel step then reads
+	// rows_per_group * 32 contiguous bytes and rows_per_group contiguous scales instead of rows_per_group 34-byte blocks a row stride apart.
+	template<uint64_t rows_per_group_new> struct q8_0_interleaved_layout {
+		static constexpr uint64_t rows_per_group{ rows_per_group_new };
+		static constexpr uint64_t alignment{ 64 };
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_scale_bytes(uint64_t block_count) noexcept {
+			return round_up_to_multiple(block_count * rows_per_group * sizeof(half), alignment);
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_group_bytes(uint64_t block_count) noexcept {
+			return get_scale_bytes(block_count) + block_count * rows_per_group * Q_SIZE;
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_group_count(uint64_t row_count) noexcept {
+			return (row_count + rows_per_group - 1) / rows_per_group;
+		}
+
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_total_bytes(uint64_t row_count, uint64_t block_count) noexcept {
+			return get_group_count(row_count) * get_group_bytes(block_count);
+		}
+
+		// row must be a multiple of rows_per_group.
+		NIHILUS_FORCE_INLINE static constexpr uint64_t get_row_offset(uint64_t row, uint64_t block_count) noexcept {
+			return (row / rows_per_group) * get_group_bytes(block_count);
+		}
+
+		// Rows past row_count in the final group are zero-filled, so kernels can always compute whole groups.
+		NIHILUS_FORCE_INLINE static void pack(const block_q8_0<half>* input, uint8_t* output, uint64_t row_count, uint64_t block_count) noexcept {
+			const uint64_t scale_bytes = get_scale_bytes(block_count);
+			const uint64_t group_bytes = get_group_bytes(block_count);
+			for (uint64_t x = 0; x < get_group_count(row_count); ++x) {
+				uint8_t* group = output + x * group_bytes;
+				half* scales   = reinterpret_cast<half*>(group);
+				int8_t* quants = reinterpret_cast<int8_t*>(group + scale_bytes);
+				std::memset(group, 0, group_bytes);
+				for (uint64_t y = 0; y < rows_per_group && x * rows_per_group + y < row_count; ++y) {
+					const block_q8_0<half>* row = input + (x * rows_per_group + y) * block_count;
+					for (uint64_t z = 0; z < block_count; ++z) {
+						scales[z * rows_per_group + y] = row[z].d;
+						std::memcpy(quants + (z * rows_per_group + y) * Q_SIZE, row[z].qs, Q_SIZE);
+					}
+				}
+			}
+		}
+	};
+
+	using packed_q8_0_layout = q8_0_interleaved_layout<cpu_arch_index == 2 ? 8 : 4>;
+
+	template<typename core_type> static constexpr bool is_packable_weight{ core_type::total_required_bytes == 0 && core_type::krn_type == kernel_type::none &&
+		std::is_same_v<typename core_type::output_type, block_q8_0<half>> && core_type::type != core_type::model_traits_type::op_type_type::token_embd_weight };
+
+}
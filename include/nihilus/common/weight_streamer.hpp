@@ -0,0 +1,352 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/model_traits.hpp>
+#include <nihilus/common/common.hpp>
+#include <nihilus/cpu/thread_pool.hpp>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <string>
+#include <vector>
+
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace nihilus {
+
+	struct streamed_tensor {
+		const uint8_t* mapped_data{};
+		void** location{};
+		uint64_t read_offset{};
+		uint64_t read_size{};
+		uint64_t staging_offset{};
+		uint64_t data_offset{};
+	};
+
+	struct weight_streamer_stats {
+		uint64_t bytes_read{};
+		uint64_t blocks_read{};
+		uint64_t read_ns{};
+		uint64_t stall_ns{};
+	};
+
+	// Layer-streaming mode for models larger than RAM - the per-block weights are never touched through the mapping; a reader thread pulls each block
+	// from the file with O_DIRECT into one of two staging slots, one block ahead of execution, and repoints that block's weight pointers into the slot
+	// before publishing it. Every execution step (one block of one token) is entered by all participants (the workers and the main thread); the
+	// reader only overwrites the slot of step s - 2 once everyone has entered step s - 1. A failed read does not stall the pool: from then on the
+	// reader repoints each block at its mapped weights instead of reading it, in the same step order, and once every block has been repointed it
+	// publishes all remaining steps and exits.
+	template<model_config config> struct weight_streamer {
+		using model_traits_type = model_traits<config.arch, config.model_size, config.model_generation>;
+		static constexpr uint64_t io_alignment{ 4096 };
+		static constexpr uint64_t slot_count{ 2 };
+		static constexpr uint64_t max_read_bytes{ 8ull * 1024ull * 1024ull };
+
+		NIHILUS_FORCE_INLINE weight_streamer() noexcept							   = default;
+		NIHILUS_FORCE_INLINE weight_streamer& operator=(const weight_streamer&) = delete;
+		NIHILUS_FORCE_INLINE weight_streamer(const weight_streamer&)			   = delete;
+
+		NIHILUS_FORCE_INLINE bool init(std::string_view path, const memory_mapped_file& model_data, const std::vector<weight_range>& ranges,
+			uint64_t participant_count_new) {
+			blocks.assign(model_traits_type::block_count, {});
+			const uint8_t* model_begin = static_cast<const uint8_t*>(model_data.data());
+			for (const auto& range: ranges) {
+				if (!range.per_block || range.block >= model_traits_type::block_count || !range.location || range.data < model_begin ||
+					range.data + range.size > model_begin + model_data.size()) {
+					continue;
+				}
+				streamed_tensor tensor{};
+				const uint64_t file_offset = static_cast<uint64_t>(range.data - model_begin);
+				tensor.mapped_data		   = range.data;
+				tensor.location			   = range.location;
+				tensor.read_offset		   = file_offset & ~(io_alignment - 1);
+				tensor.data_offset		   = file_offset - tensor.read_offset;
+				tensor.read_size		   = round_up_to_multiple(tensor.data_offset + range.size, io_alignment);
+				blocks[range.block].emplace_back(tensor);
+			}
+			slot_bytes = 0;
+			for (auto& block: blocks) {
+				uint64_t offset{};
+				for (auto& tensor: block) {
+					tensor.staging_offset = offset;
+					offset += tensor.read_size;
+				}
+				slot_bytes = std::max(slot_bytes, offset);
+			}
+			if (slot_bytes == 0) {
+				log<log_level::error>("weight_streamer: no per-block weights to stream.");
+				return false;
+			}
+			if (!open_file(path) || !map_staging()) {
+				return false;
+			}
+			participant_count = participant_count_new;
+			participant_steps.assign(participant_count, 0);
+			arrivals.store(0, std::memory_order_release);
+			ready_step.store(0, std::memory_order_release);
+			stop.store(false, std::memory_order_release);
+			failed.store(false, std::memory_order_release);
+			io_thread = std::thread{ [this] {
+				read_loop();
+			} };
+			log<log_level::status>("weight_streamer: streaming " + std::to_string(model_traits_type::block_count) + " blocks through 2 x " +
+				std::to_string(slot_bytes / (1024ull * 1024ull)) + " MB staging slots" + (direct_io ? " with O_DIRECT." : " (O_DIRECT unavailable, using buffered reads)."));
+			return true;
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return staging_data != nullptr;
+		}
+
+		// Called by every participant as it starts a block; returns once that block's weights are resident.
+		NIHILUS_FORCE_INLINE void enter_block(uint64_t participant_index) noexcept {
+			const uint64_t step = participant_steps[participant_index]++;
+			arrivals.fetch_add(1, std::memory_order_acq_rel);
+			arrivals.notify_all();
+			uint64_t ready = ready_step.load(std::memory_order_acquire);
+			if NIHILUS_LIKELY (ready > step) {
+				return;
+			}
+			const auto start = std::chrono::steady_clock::now();
+			while (ready <= step) {
+				ready_step.wait(ready, std::memory_order_acquire);
+				ready = ready_step.load(std::memory_order_acquire);
+			}
+			stall_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()),
+				std::memory_order_relaxed);
+		}
+
+		// Set once a read has failed and the streamer has fallen back to the mapped weights.
+		NIHILUS_FORCE_INLINE bool has_failed() const noexcept {
+			return failed.load(std::memory_order_acquire);
+		}
+
+		NIHILUS_FORCE_INLINE weight_streamer_stats get_stats() const noexcept {
+			weight_streamer_stats return_value{};
+			return_value.bytes_read	 = bytes_read.load(std::memory_order_relaxed);
+			return_value.blocks_read = blocks_read.load(std::memory_order_relaxed);
+			return_value.read_ns	 = read_ns.load(std::memory_order_relaxed);
+			return_value.stall_ns	 = stall_ns.load(std::memory_order_relaxed);
+			return return_value;
+		}
+
+		NIHILUS_FORCE_INLINE void log_stats() const {
+			const weight_streamer_stats stats{ get_stats() };
+			const uint64_t megabytes_per_second = stats.bytes_read / std::max<uint64_t>(stats.read_ns / 1000ull, 1);
+			log<log_level::status>("weight_streamer: read " + std::to_string(stats.blocks_read) + " blocks (" + std::to_string(stats.bytes_read / (1024ull * 1024ull)) +
+				" MB) at " + std::to_string(megabytes_per_second) + " MB/s, compute stalled " + std::to_string(stats.stall_ns / 1000000ull) + " ms waiting for weights" +
+				(has_failed() ? ", then fell back to the memory-mapped weights after a read error." : "."));
+		}
+
+		NIHILUS_FORCE_INLINE ~weight_streamer() {
+			if (io_thread.joinable()) {
+				stop.store(true, std::memory_order_release);
+				arrivals.fetch_add(1, std::memory_order_acq_rel);
+				arrivals.notify_all();
+				io_thread.join();
+			}
+			unmap_staging();
+			close_file();
+		}
+
+	  protected:
+		std::vector<std::vector<streamed_tensor>> blocks{};
+		std::vector<uint64_t> participant_steps{};
+		std::atomic<uint64_t> blocks_read{};
+		std::atomic<uint64_t> bytes_read{};
+		std::atomic<uint64_t> ready_step{};
+		std::atomic<uint64_t> arrivals{};
+		std::atomic<uint64_t> stall_ns{};
+		std::atomic<uint64_t> read_ns{};
+		std::atomic<bool> failed{};
+		std::atomic<bool> stop{};
+		uint64_t participant_count{};
+		uint8_t* staging_data{};
+		std::thread io_thread{};
+		uint64_t slot_bytes{};
+		int file_descriptor{ -1 };
+		bool direct_io{};
+
+		NIHILUS_FORCE_INLINE void read_loop() {
+			uint64_t mapped_blocks{};
+			for (uint64_t step = 0; !stop.load(std::memory_order_acquire); ++step) {
+				if (step >= slot_count) {
+					const uint64_t required = step * participant_count;
+					uint64_t current		= arrivals.load(std::memory_order_acquire);
+					while (current < required && !stop.load(std::memory_order_acquire)) {
+						arrivals.wait(current, std::memory_order_acquire);
+						current = arrivals.load(std::memory_order_acquire);
+					}
+					if (stop.load(std::memory_order_acquire)) {
+						return;
+					}
+				}
+				const uint64_t block = step % model_traits_type::block_count;
+				if (!failed.load(std::memory_order_relaxed) && !read_block(block, staging_data + (step % slot_count) * slot_bytes)) {
+					log<log_level::error>("weight_streamer: failed to read block " + std::to_string(block) + ", falling back to the memory-mapped weights.");
+					failed.store(true, std::memory_order_release);
+				}
+				if (failed.load(std::memory_order_relaxed)) {
+					map_block(block);
+					if (++mapped_blocks == model_traits_type::block_count) {
+						ready_step.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+						ready_step.notify_all();
+						return;
+					}
+				}
+				ready_step.store(step + 1, std::memory_order_release);
+				ready_step.notify_all();
+			}
+		}
+
+		NIHILUS_FORCE_INLINE bool read_block(uint64_t block, uint8_t* slot) {
+			const auto start = std::chrono::steady_clock::now();
+			uint64_t total_bytes{};
+			for (const auto& tensor: blocks[block]) {
+				if (!read_range(slot + tensor.staging_offset, tensor.read_offset, tensor.read_size)) {
+					return false;
+				}
+				*tensor.location = slot + tensor.staging_offset + tensor.data_offset;
+				total_bytes += tensor.read_size;
+			}
+			read_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()),
+				std::memory_order_relaxed);
+			bytes_read.fetch_add(total_bytes, std::memory_order_relaxed);
+			blocks_read.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Only called for a block no participant is executing, under the same step ordering as read_block.
+		NIHILUS_FORCE_INLINE void map_block(uint64_t block) noexcept {
+			for (const auto& tensor: blocks[block]) {
+				*tensor.location = const_cast<uint8_t*>(tensor.mapped_data);
+			}
+		}
+
+		// Reads past the end of the file come back short, which is fine - only the tensor bytes inside the aligned span are used.
+		NIHILUS_FORCE_INLINE bool read_range(uint8_t* destination, uint64_t offset, uint64_t size) {
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+			( void )destination;
+			( void )offset;
+			( void )size;
+			return false;
+#else
+			uint64_t done{};
+			while (done < size) {
+				const uint64_t request = std::min(max_read_bytes, size - done);
+				const ssize_t result   = pread(file_descriptor, destination + done, request, static_cast<off_t>(offset + done));
+				if (result < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					// Some filesystems accept O_DIRECT at open time and only reject it on the first read.
+					if (errno == EINVAL && direct_io && reopen_buffered()) {
+						continue;
+					}
+					log<log_level::error>("weight_streamer: read failed: " + std::string{ std::strerror(errno) });
+					return false;
+				}
+				if (result == 0) {
+					break;
+				}
+				done += static_cast<uint64_t>(result);
+			}
+			return true;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE bool open_file(std::string_view path) {
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+			( void )path;
+			log<log_level::error>("weight_streamer: weight streaming is not supported on this platform.");
+			return false;
+#else
+			const std::string path_string{ path };
+	#if defined(O_DIRECT)
+			file_descriptor = open(path_string.c_str(), O_RDONLY | O_DIRECT);
+			direct_io		= file_descriptor != -1;
+	#endif
+			if (file_descriptor == -1) {
+				file_descriptor = open(path_string.c_str(), O_RDONLY);
+			}
+			if (file_descriptor == -1) {
+				log<log_level::error>("weight_streamer: failed to open " + path_string + ": " + std::string{ std::strerror(errno) });
+				return false;
+			}
+			return true;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE bool reopen_buffered() {
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+			return false;
+#else
+			const int flags = fcntl(file_descriptor, F_GETFL);
+			if (flags == -1 || fcntl(file_descriptor, F_SETFL, flags & ~O_DIRECT) == -1) {
+				return false;
+			}
+			direct_io = false;
+			log<log_level::status>("weight_streamer: O_DIRECT reads were rejected, falling back to buffered reads.");
+			return true;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE void close_file() noexcept {
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+			if (file_descriptor != -1) {
+				close(file_descriptor);
+				file_descriptor = -1;
+			}
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE bool map_staging() {
+#if defined(NIHILUS_PLATFORM_WINDOWS)
+			return false;
+#else
+			void* result = mmap(nullptr, slot_bytes * slot_count, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (result == MAP_FAILED) {
+				log<log_level::error>("weight_streamer: failed to allocate the staging slots: " + std::string{ std::strerror(errno) });
+				return false;
+			}
+			staging_data = static_cast<uint8_t*>(result);
+			return true;
+#endif
+		}
+
+		NIHILUS_FORCE_INLINE void unmap_staging() noexcept {
+#if !defined(NIHILUS_PLATFORM_WINDOWS)
+			if (staging_data) {
+				munmap(staging_data, slot_bytes * slot_count);
+				staging_data = nullptr;
+			}
+#endif
+		}
+	};
+
+}
@@ -20,6 +20,7 @@ RealTimeChris (Chris M.)
 #pragma once
 
 #include <nihilus/common/kernel_traits.hpp>
+#include <nihilus/common/sampling.hpp>
 
 #if defined(NIHILUS_NEON)
 
@@ -27,102 +28,221 @@ RealTimeChris (Chris M.)
 
 namespace nihilus {
 
+	template<> struct argmax_kernel<1> {
+		NIHILUS_FORCE_INLINE static argmax_result impl(const float* values, uint64_t count) noexcept {
+			float32x4_t maxima[4];
+			for (uint64_t y = 0; y < 4; ++y) {
+				maxima[y] = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+			}
+			uint64_t x{};
+			for (; x + 16 <= count; x += 16) {
+				for (uint64_t y = 0; y < 4; ++y) {
+					maxima[y] = vmaxnmq_f32(vld1q_f32(values + x + y * 4), maxima[y]);
+				}
+			}
+			float maximum = vmaxnmvq_f32(vmaxnmq_f32(vmaxnmq_f32(maxima[0], maxima[1]), vmaxnmq_f32(maxima[2], maxima[3])));
+			for (; x < count; ++x) {
+				maximum = values[x] > maximum ? values[x] : maximum;
+			}
+			if (maximum == -std::numeric_limits<float>::infinity()) {
+				return {};
+			}
+			const float32x4_t target = vdupq_n_f32(maximum);
+			for (x = 0; x + 4 <= count; x += 4) {
+				if (vmaxvq_u32(vceqq_f32(vld1q_f32(values + x), target)) != 0) {
+					break;
+				}
+			}
+			for (; values[x] != maximum; ++x) {
+			}
+			return argmax_result{ maximum, static_cast<int32_t>(x) };
+		}
+	};
+
+	template<> struct threshold_select_kernel<1> {
+		NIHILUS_FORCE_INLINE static uint64_t impl(const float* values, uint64_t count, float threshold, uint32_t first, uint32_t* output) noexcept {
+			const float32x4_t limit = vdupq_n_f32(threshold);
+			uint64_t size{};
+			uint64_t x{};
+			for (; x + 16 <= count; x += 16) {
+				const uint32x4_t any = vorrq_u32(vorrq_u32(vcgtq_f32(vld1q_f32(values + x), limit), vcgtq_f32(vld1q_f32(values + x + 4), limit)),
+					vorrq_u32(vcgtq_f32(vld1q_f32(values + x + 8), limit), vcgtq_f32(vld1q_f32(values + x + 12), limit)));
+				if (vmaxvq_u32(any) != 0) {
+					for (uint64_t y = x; y < x + 16; ++y) {
+						if (values[y] > threshold) {
+							output[size++] = first + static_cast<uint32_t>(y);
+						}
+					}
+				}
+			}
+			for (; x < count; ++x) {
+				if (values[x] > threshold) {
+					output[size++] = first + static_cast<uint32_t>(x);
+				}
+			}
+			return size;
+		}
+	};
+
+	template<> struct token_mask_kernel<1> {
+		NIHILUS_FORCE_INLINE static void impl(float* values, uint64_t count, const uint64_t* mask, uint64_t first) noexcept {
+			uint64_t x{};
+			for (; x < count && ((first + x) & 3) != 0; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+			static constexpr uint32_t lane_values[4]{ 1, 2, 4, 8 };
+			const uint32x4_t lane_bits = vld1q_u32(lane_values);
+			const float32x4_t masked   = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+			for (; x + 4 <= count; x += 4) {
+				const uint64_t bits = (mask[(first + x) >> 6] >> ((first + x) & 63)) & 0xF;
+				if (bits != 0xF) {
+					const uint32x4_t allowed = vtstq_u32(vdupq_n_u32(static_cast<uint32_t>(bits)), lane_bits);
+					vst1q_f32(values + x, vbslq_f32(allowed, vld1q_f32(values + x), masked));
+				}
+			}
+			for (; x < count; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+		}
+	};
+
+	NIHILUS_FORCE_INLINE float32x4_t exp_non_positive(float32x4_t x) noexcept {
+		const float32x4_t lower	 = vdupq_n_f32(-87.3f);
+		const uint32x4_t valid	 = vcgeq_f32(x, lower);
+		x						 = vmaxnmq_f32(x, lower);
+		const float32x4_t n		 = vrndnq_f32(vmulq_n_f32(x, 1.44269504088896341f));
+		float32x4_t r			 = vfmsq_f32(x, n, vdupq_n_f32(0.693359375f));
+		r						 = vfmsq_f32(r, n, vdupq_n_f32(-2.12194440e-4f));
+		float32x4_t polynomial	 = vdupq_n_f32(1.9875691500e-4f);
+		polynomial				 = vfmaq_f32(vdupq_n_f32(1.3981999507e-3f), polynomial, r);
+		polynomial				 = vfmaq_f32(vdupq_n_f32(8.3334519073e-3f), polynomial, r);
+		polynomial				 = vfmaq_f32(vdupq_n_f32(4.1665795894e-2f), polynomial, r);
+		polynomial				 = vfmaq_f32(vdupq_n_f32(1.6666665459e-1f), polynomial, r);
+		polynomial				 = vfmaq_f32(vdupq_n_f32(5.0000001201e-1f), polynomial, r);
+		polynomial				 = vfmaq_f32(vaddq_f32(r, vdupq_n_f32(1.0f)), polynomial, vmulq_f32(r, r));
+		const int32x4_t power	 = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+		const float32x4_t result = vmulq_f32(polynomial, vreinterpretq_f32_s32(power));
+		return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(result), valid));
+	}
+
+	template<> struct exp_sum_kernel<1> {
+		NIHILUS_FORCE_INLINE static float impl(const float* values, uint64_t count, float maximum, float scale) noexcept {
+			const float32x4_t offset = vdupq_n_f32(maximum);
+			float32x4_t sums[2]{ vdupq_n_f32(0.0f), vdupq_n_f32(0.0f) };
+			uint64_t x{};
+			for (; x + 8 <= count; x += 8) {
+				for (uint64_t y = 0; y < 2; ++y) {
+					sums[y] = vaddq_f32(sums[y], exp_non_positive(vmulq_n_f32(vsubq_f32(vld1q_f32(values + x + y * 4), offset), scale)));
+				}
+			}
+			float sum = vaddvq_f32(vaddq_f32(sums[0], sums[1]));
+			for (; x < count; ++x) {
+				sum += values[x] > -std::numeric_limits<float>::infinity() ? std::exp((values[x] - maximum) * scale) : 0.0f;
+			}
+			return sum;
+		}
+	};
+
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::copy, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::copy, transform_type, core_type, half, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::cont, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::cont, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::silu, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::silu, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::rms_norm, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::rms_norm, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::get_rows, transform_type, core_type, float, block_q8_0<half>, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, block_q8_0<half>, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::get_rows, transform_type, core_type, float, float, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, float, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul, transform_type, core_type, float, float, block_q8_0<half>>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, block_q8_0<half>> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, block_q8_0<half>, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, block_q8_0<half>, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, half, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::softmax, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::softmax, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::add, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::add, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::rope, transform_type, core_type, float, float, int32_t, float>
 		: public kernel_base<core_type::type, kernel_type::rope, core_type, float, float, int32_t, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02, const typename core_type::input_type03& input03) {
 		}
 	};
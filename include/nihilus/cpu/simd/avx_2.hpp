@@ -20,106 +20,238 @@ RealTimeChris (Chris M.)
 #pragma once
 
 #include <nihilus/common/kernel_traits.hpp>
+#include <nihilus/common/sampling.hpp>
 
 #if defined(NIHILUS_AVX2)
 
 namespace nihilus {
 
+	NIHILUS_FORCE_INLINE float horizontal_sum(__m256 value) noexcept {
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+		sum		   = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum		   = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+		return _mm_cvtss_f32(sum);
+	}
+
+	// Two passes: the maximum, with NaNs dropped by the operand order of max_ps, then the first position that holds it. On the fused path the slice
+	// was just written by the same thread, so the second pass reads from cache.
+	template<> struct argmax_kernel<1> {
+		NIHILUS_FORCE_INLINE static argmax_result impl(const float* values, uint64_t count) noexcept {
+			__m256 maxima[4];
+			for (uint64_t y = 0; y < 4; ++y) {
+				maxima[y] = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+			}
+			uint64_t x{};
+			for (; x + 32 <= count; x += 32) {
+				for (uint64_t y = 0; y < 4; ++y) {
+					maxima[y] = _mm256_max_ps(_mm256_loadu_ps(values + x + y * 8), maxima[y]);
+				}
+			}
+			alignas(32) float lanes[8];
+			_mm256_store_ps(lanes, _mm256_max_ps(_mm256_max_ps(maxima[0], maxima[1]), _mm256_max_ps(maxima[2], maxima[3])));
+			float maximum = -std::numeric_limits<float>::infinity();
+			for (uint64_t y = 0; y < 8; ++y) {
+				maximum = lanes[y] > maximum ? lanes[y] : maximum;
+			}
+			for (; x < count; ++x) {
+				maximum = values[x] > maximum ? values[x] : maximum;
+			}
+			if (maximum == -std::numeric_limits<float>::infinity()) {
+				return {};
+			}
+			const __m256 target = _mm256_set1_ps(maximum);
+			for (x = 0; x + 8 <= count; x += 8) {
+				if (const int32_t mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + x), target, _CMP_EQ_OQ)); mask != 0) {
+					return argmax_result{ maximum, static_cast<int32_t>(x + static_cast<uint64_t>(std::countr_zero(static_cast<uint32_t>(mask)))) };
+				}
+			}
+			for (; values[x] != maximum; ++x) {
+			}
+			return argmax_result{ maximum, static_cast<int32_t>(x) };
+		}
+	};
+
+	template<> struct threshold_select_kernel<1> {
+		NIHILUS_FORCE_INLINE static uint64_t impl(const float* values, uint64_t count, float threshold, uint32_t first, uint32_t* output) noexcept {
+			const __m256 limit = _mm256_set1_ps(threshold);
+			uint64_t size{};
+			uint64_t x{};
+			for (; x + 8 <= count; x += 8) {
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + x), limit, _CMP_GT_OQ)));
+				while (mask != 0) {
+					output[size++] = first + static_cast<uint32_t>(x) + static_cast<uint32_t>(std::countr_zero(mask));
+					mask &= mask - 1;
+				}
+			}
+			for (; x < count; ++x) {
+				if (values[x] > threshold) {
+					output[size++] = first + static_cast<uint32_t>(x);
+				}
+			}
+			return size;
+		}
+	};
+
+	template<> struct token_mask_kernel<1> {
+		NIHILUS_FORCE_INLINE static void impl(float* values, uint64_t count, const uint64_t* mask, uint64_t first) noexcept {
+			uint64_t x{};
+			for (; x < count && ((first + x) & 7) != 0; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+			const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+			const __m256 masked		= _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+			for (; x + 8 <= count; x += 8) {
+				const uint64_t bits = (mask[(first + x) >> 6] >> ((first + x) & 63)) & 0xFF;
+				if (bits == 0xFF) {
+					continue;
+				}
+				const __m256i allowed = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int32_t>(bits)), lane_bits), lane_bits);
+				_mm256_storeu_ps(values + x, _mm256_blendv_ps(masked, _mm256_loadu_ps(values + x), _mm256_castsi256_ps(allowed)));
+			}
+			for (; x < count; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+		}
+	};
+
+	// exp for x <= 0: x = n * ln2 + r with |r| <= ln2 / 2, a degree-6 polynomial for e^r and n added to the exponent bits. Inputs below the smallest
+	// normal result (including -inf and NaN) return 0.
+	NIHILUS_FORCE_INLINE __m256 exp_non_positive(__m256 x) noexcept {
+		const __m256 lower	= _mm256_set1_ps(-87.3f);
+		const __m256 valid	= _mm256_cmp_ps(x, lower, _CMP_GE_OQ);
+		x					= _mm256_max_ps(x, lower);
+		const __m256 n		= _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256 r			= _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+		r					= _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+		__m256 polynomial	= _mm256_set1_ps(1.9875691500e-4f);
+		polynomial			= _mm256_fmadd_ps(polynomial, r, _mm256_set1_ps(1.3981999507e-3f));
+		polynomial			= _mm256_fmadd_ps(polynomial, r, _mm256_set1_ps(8.3334519073e-3f));
+		polynomial			= _mm256_fmadd_ps(polynomial, r, _mm256_set1_ps(4.1665795894e-2f));
+		polynomial			= _mm256_fmadd_ps(polynomial, r, _mm256_set1_ps(1.6666665459e-1f));
+		polynomial			= _mm256_fmadd_ps(polynomial, r, _mm256_set1_ps(5.0000001201e-1f));
+		polynomial			= _mm256_fmadd_ps(polynomial, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+		const __m256i power = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_and_ps(_mm256_mul_ps(polynomial, _mm256_castsi256_ps(power)), valid);
+	}
+
+	template<> struct exp_sum_kernel<1> {
+		NIHILUS_FORCE_INLINE static float impl(const float* values, uint64_t count, float maximum, float scale) noexcept {
+			const __m256 offset = _mm256_set1_ps(maximum);
+			const __m256 factor = _mm256_set1_ps(scale);
+			__m256 sums[2]{ _mm256_setzero_ps(), _mm256_setzero_ps() };
+			uint64_t x{};
+			for (; x + 16 <= count; x += 16) {
+				for (uint64_t y = 0; y < 2; ++y) {
+					sums[y] = _mm256_add_ps(sums[y], exp_non_positive(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + x + y * 8), offset), factor)));
+				}
+			}
+			float sum = horizontal_sum(_mm256_add_ps(sums[0], sums[1]));
+			for (; x < count; ++x) {
+				sum += values[x] > -std::numeric_limits<float>::infinity() ? std::exp((values[x] - maximum) * scale) : 0.0f;
+			}
+			return sum;
+		}
+	};
+
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::copy, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::copy, transform_type, core_type, half, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::cont, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::cont, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::silu, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::silu, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::rms_norm, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::rms_norm, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {}
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {}
 	};
 	
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::get_rows, transform_type, core_type, float, block_q8_0<half>, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, block_q8_0<half>, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::get_rows, transform_type, core_type, float, float, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, float, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 	
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl < 1, kernel_type::mul, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 	
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul, transform_type, core_type, float, float, block_q8_0<half>>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, block_q8_0<half>> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, block_q8_0<half> ,float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, block_q8_0<half> ,float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::mul_mat, transform_type, core_type, float, half, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::softmax, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::softmax, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::add, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::add, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<1, kernel_type::rope, transform_type, core_type, float, float, int32_t, float>
 		: public kernel_base<core_type::type, kernel_type::rope, core_type, float, float, int32_t, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02, const typename core_type::input_type03& input03) {
 		}
 	};
@@ -1,106 +1,219 @@
 #pragma once
 #include <nihilus/common/kernel_traits.hpp>
+#include <nihilus/common/sampling.hpp>
 
-#if defined(NIHILUS_AVX522)
+#if defined(NIHILUS_AVX512)
 
 namespace nihilus {
 
+	template<> struct argmax_kernel<2> {
+		NIHILUS_FORCE_INLINE static argmax_result impl(const float* values, uint64_t count) noexcept {
+			__m512 maxima[4];
+			for (uint64_t y = 0; y < 4; ++y) {
+				maxima[y] = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+			}
+			uint64_t x{};
+			for (; x + 64 <= count; x += 64) {
+				for (uint64_t y = 0; y < 4; ++y) {
+					maxima[y] = _mm512_max_ps(_mm512_loadu_ps(values + x + y * 16), maxima[y]);
+				}
+			}
+			float maximum = _mm512_reduce_max_ps(_mm512_max_ps(_mm512_max_ps(maxima[0], maxima[1]), _mm512_max_ps(maxima[2], maxima[3])));
+			for (; x < count; ++x) {
+				maximum = values[x] > maximum ? values[x] : maximum;
+			}
+			if (maximum == -std::numeric_limits<float>::infinity()) {
+				return {};
+			}
+			const __m512 target = _mm512_set1_ps(maximum);
+			for (x = 0; x + 16 <= count; x += 16) {
+				if (const __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + x), target, _CMP_EQ_OQ); mask != 0) {
+					return argmax_result{ maximum, static_cast<int32_t>(x + static_cast<uint64_t>(std::countr_zero(static_cast<uint32_t>(mask)))) };
+				}
+			}
+			for (; values[x] != maximum; ++x) {
+			}
+			return argmax_result{ maximum, static_cast<int32_t>(x) };
+		}
+	};
+
+	template<> struct threshold_select_kernel<2> {
+		NIHILUS_FORCE_INLINE static uint64_t impl(const float* values, uint64_t count, float threshold, uint32_t first, uint32_t* output) noexcept {
+			const __m512 limit = _mm512_set1_ps(threshold);
+			const __m512i step = _mm512_set1_epi32(16);
+			__m512i positions  = _mm512_add_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(static_cast<int32_t>(first)));
+			uint64_t size{};
+			uint64_t x{};
+			for (; x + 16 <= count; x += 16) {
+				const __mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + x), limit, _CMP_GT_OQ);
+				_mm512_mask_compressstoreu_epi32(output + size, mask, positions);
+				size += static_cast<uint64_t>(std::popcount(static_cast<uint32_t>(mask)));
+				positions = _mm512_add_epi32(positions, step);
+			}
+			for (; x < count; ++x) {
+				if (values[x] > threshold) {
+					output[size++] = first + static_cast<uint32_t>(x);
+				}
+			}
+			return size;
+		}
+	};
+
+	template<> struct token_mask_kernel<2> {
+		NIHILUS_FORCE_INLINE static void impl(float* values, uint64_t count, const uint64_t* mask, uint64_t first) noexcept {
+			uint64_t x{};
+			for (; x < count && ((first + x) & 15) != 0; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+			const __m512 masked = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+			for (; x + 16 <= count; x += 16) {
+				const __mmask16 allowed = static_cast<__mmask16>(mask[(first + x) >> 6] >> ((first + x) & 63));
+				if (allowed != 0xFFFF) {
+					_mm512_storeu_ps(values + x, _mm512_mask_loadu_ps(masked, allowed, values + x));
+				}
+			}
+			for (; x < count; ++x) {
+				if (((mask[(first + x) >> 6] >> ((first + x) & 63)) & 1) == 0) {
+					values[x] = -std::numeric_limits<float>::infinity();
+				}
+			}
+		}
+	};
+
+	NIHILUS_FORCE_INLINE __m512 exp_non_positive(__m512 x) noexcept {
+		const __m512 lower		= _mm512_set1_ps(-87.3f);
+		const __mmask16 valid	= _mm512_cmp_ps_mask(x, lower, _CMP_GE_OQ);
+		x						= _mm512_max_ps(x, lower);
+		const __m512 n			= _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m512 r				= _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+		r						= _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+		__m512 polynomial		= _mm512_set1_ps(1.9875691500e-4f);
+		polynomial				= _mm512_fmadd_ps(polynomial, r, _mm512_set1_ps(1.3981999507e-3f));
+		polynomial				= _mm512_fmadd_ps(polynomial, r, _mm512_set1_ps(8.3334519073e-3f));
+		polynomial				= _mm512_fmadd_ps(polynomial, r, _mm512_set1_ps(4.1665795894e-2f));
+		polynomial				= _mm512_fmadd_ps(polynomial, r, _mm512_set1_ps(1.6666665459e-1f));
+		polynomial				= _mm512_fmadd_ps(polynomial, r, _mm512_set1_ps(5.0000001201e-1f));
+		polynomial				= _mm512_fmadd_ps(polynomial, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+		return _mm512_maskz_scalef_ps(valid, polynomial, n);
+	}
+
+	template<> struct exp_sum_kernel<2> {
+		NIHILUS_FORCE_INLINE static float impl(const float* values, uint64_t count, float maximum, float scale) noexcept {
+			const __m512 offset = _mm512_set1_ps(maximum);
+			const __m512 factor = _mm512_set1_ps(scale);
+			__m512 sums[2]{ _mm512_setzero_ps(), _mm512_setzero_ps() };
+			uint64_t x{};
+			for (; x + 32 <= count; x += 32) {
+				for (uint64_t y = 0; y < 2; ++y) {
+					sums[y] = _mm512_add_ps(sums[y], exp_non_positive(_mm512_mul_ps(_mm512_sub_ps(_mm512_loadu_ps(values + x + y * 16), offset), factor)));
+				}
+			}
+			float sum = _mm512_reduce_add_ps(_mm512_add_ps(sums[0], sums[1]));
+			for (; x < count; ++x) {
+				sum += values[x] > -std::numeric_limits<float>::infinity() ? std::exp((values[x] - maximum) * scale) : 0.0f;
+			}
+			return sum;
+		}
+	};
+
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::copy, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::copy, transform_type, core_type, half, float>
 		: public kernel_base<core_type::type, kernel_type::copy, core_type, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::cont, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::cont, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::silu, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::silu, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::rms_norm, transform_type, core_type, float, float>
 		: public kernel_base<core_type::type, kernel_type::rms_norm, core_type, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01) {
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::get_rows, transform_type, core_type, float, block_q8_0<half>, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, block_q8_0<half>, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::get_rows, transform_type, core_type, float, float, int32_t>
 		: public kernel_base<core_type::type, kernel_type::get_rows, core_type, float, float, int32_t> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::mul, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::mul, transform_type, core_type, float, float, block_q8_0<half>>
 		: public kernel_base<core_type::type, kernel_type::mul, core_type, float, float, block_q8_0<half>> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::mul_mat, transform_type, core_type, float, block_q8_0<half>, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, block_q8_0<half>, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::mul_mat, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::mul_mat, transform_type, core_type, float, half, float>
 		: public kernel_base<core_type::type, kernel_type::mul_mat, core_type, float, half, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::softmax, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::softmax, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::add, transform_type, core_type, float, float, float>
 		: public kernel_base<core_type::type, kernel_type::add, core_type, float, float, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02) {
 		}
 	};
 
 	template<typename transform_type, typename core_type> struct kernel_dispatcher_impl<2, kernel_type::rope, transform_type, core_type, float, float, int32_t, float>
 		: public kernel_base<core_type::type, kernel_type::rope, core_type, float, float, int32_t, float> {
-		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, core_type& output, const typename core_type::input_type01& input01,
+		NIHILUS_FORCE_INLINE static void impl(size_t thread_index, size_t thread_count, const work_partition& partition, core_type& output, const typename core_type::input_type01& input01,
 			const typename core_type::input_type02& input02, const typename core_type::input_type03& input03) {
 		}
 	};
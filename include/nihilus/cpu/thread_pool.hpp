@@ -21,8 +21,11 @@ RealTimeChris (Chris M.)
 #pragma once
 
 #include <nihilus/common/monolithic_dispatcher.hpp>
+#include <nihilus/common/weight_packing.hpp>
+#include <nihilus/cpu/topology.hpp>
 #include <nihilus/common/common.hpp>
 #include <nihilus/common/tuple.hpp>
+#include <functional>
 #include <atomic>
 #include <thread>
 #include <latch>
@@ -270,15 +273,14 @@ namespace nihilus {
 		using output_type															 = base_type::output_type;
 		template<typename memory_buffer_type> NIHILUS_FORCE_INLINE static void impl(base_type& core, memory_buffer_type& memory_buffer) {
 			if constexpr (base_type::total_required_bytes > 0) {
-				output_type* ptr = static_cast<output_type*>(memory_buffer.claim_memory(core.total_required_bytes));
 				tensor_debugger::compare_tensor_data(core, 0);
 				if constexpr (array_type<decltype(core.data)>) {
 					for (uint64_t x = 0; x < base_type::model_traits_type::block_count; ++x) {
 						tensor_debugger::compare_tensor_data(core, x);
-						core.data[x] = ptr;
+						core.data[x] = static_cast<output_type*>(memory_buffer.claim_memory(core.total_required_bytes));
 					}
 				} else {
-					core.data = ptr;
+					core.data = static_cast<output_type*>(memory_buffer.claim_memory(core.total_required_bytes));
 				}
 			} else {
 				tensor_debugger::compare_tensor_data(core, 0);
@@ -286,6 +288,171 @@ namespace nihilus {
 		}
 	};
 
+	template<typename base_type> struct weight_repacker {
+		NIHILUS_FORCE_INLINE weight_repacker() noexcept								   = default;
+		NIHILUS_FORCE_INLINE weight_repacker& operator=(const weight_repacker&) noexcept = delete;
+		NIHILUS_FORCE_INLINE weight_repacker(const weight_repacker&) noexcept			   = delete;
+		NIHILUS_FORCE_INLINE weight_repacker& operator=(weight_repacker&&) noexcept	   = delete;
+		NIHILUS_FORCE_INLINE weight_repacker(weight_repacker&&) noexcept				   = delete;
+		using output_type															   = base_type::output_type;
+		static constexpr uint64_t row_count{ base_type::dims[1] * base_type::dims[2] * base_type::dims[3] };
+		static constexpr uint64_t block_count{ base_type::dims[0] / Q_SIZE };
+		static constexpr uint64_t source_bytes{ row_count * base_type::strides[1] };
+		static constexpr uint64_t packed_bytes{ packed_q8_0_layout::get_total_bytes(row_count, block_count) };
+		static constexpr uint64_t tensor_count{ array_type<decltype(std::declval<base_type&>().data)> ? base_type::model_traits_type::block_count : 1 };
+
+		NIHILUS_FORCE_INLINE static void impl(base_type&, uint64_t& required_bytes) {
+			if constexpr (is_packable_weight<base_type>) {
+				required_bytes += round_up_to_multiple(packed_bytes, cpu_alignment) * tensor_count;
+			}
+		}
+
+		// The source rows are released from the model mapping once copied, so the process keeps a single resident copy of every weight.
+		template<typename memory_buffer_type, typename mapped_file_type>
+		NIHILUS_FORCE_INLINE static void repack(output_type*& ptr, memory_buffer_type& memory_buffer, mapped_file_type& model_data, uint64_t& repacked_bytes) {
+			if (!ptr) {
+				return;
+			}
+			uint8_t* packed = static_cast<uint8_t*>(memory_buffer.claim_memory(packed_bytes));
+			if (!packed) {
+				return;
+			}
+			packed_q8_0_layout::pack(ptr, packed, row_count, block_count);
+			const uint8_t* model_begin = static_cast<const uint8_t*>(model_data.data());
+			const uint8_t* source	   = reinterpret_cast<const uint8_t*>(ptr);
+			if (source >= model_begin && source + source_bytes <= model_begin + model_data.size()) {
+				const uint64_t offset = static_cast<uint64_t>(source - model_begin);
+				model_data.unmap_fragment(offset, offset + source_bytes);
+			}
+			ptr = reinterpret_cast<output_type*>(packed);
+			repacked_bytes += packed_bytes;
+		}
+
+		template<typename memory_buffer_type, typename mapped_file_type>
+		NIHILUS_FORCE_INLINE static void impl(base_type& core, memory_buffer_type& memory_buffer, mapped_file_type& model_data, uint64_t& repacked_bytes) {
+			if constexpr (is_packable_weight<base_type>) {
+				if constexpr (array_type<decltype(core.data)>) {
+					for (uint64_t x = 0; x < base_type::model_traits_type::block_count; ++x) {
+						repack(core.data[x], memory_buffer, model_data, repacked_bytes);
+					}
+				} else {
+					repack(core.data, memory_buffer, model_data, repacked_bytes);
+				}
+			}
+		}
+	};
+
+	struct weight_range {
+		const uint8_t* data{};
+		void** location{};
+		uint64_t size{};
+		uint64_t block{};
+		bool per_block{};
+	};
+
+	// Gathers the resident byte range of every weight tensor, tagged with the block that consumes it (output weights sort after the last block) and
+	// with the pointer that refers to it.
+	template<typename base_type> struct weight_range_collector {
+		NIHILUS_FORCE_INLINE weight_range_collector() noexcept										   = default;
+		NIHILUS_FORCE_INLINE weight_range_collector& operator=(const weight_range_collector&) noexcept = delete;
+		NIHILUS_FORCE_INLINE weight_range_collector(const weight_range_collector&) noexcept			   = delete;
+		NIHILUS_FORCE_INLINE weight_range_collector& operator=(weight_range_collector&&) noexcept	   = delete;
+		NIHILUS_FORCE_INLINE weight_range_collector(weight_range_collector&&) noexcept				   = delete;
+		using output_type																			   = base_type::output_type;
+		using model_traits_type																		   = typename base_type::model_traits_type;
+		using op_type_type																			   = typename model_traits_type::op_type_type;
+		static constexpr uint64_t row_count{ base_type::dims[1] * base_type::dims[2] * base_type::dims[3] };
+		static constexpr uint64_t block_count{ base_type::dims[0] / Q_SIZE };
+		static constexpr uint64_t consumption_block{ base_type::type == op_type_type::output_weight || base_type::type == op_type_type::output_norm_weight
+				? model_traits_type::block_count
+				: 0 };
+
+		NIHILUS_FORCE_INLINE static uint64_t get_byte_count(bool packed) noexcept {
+			if constexpr (is_packable_weight<base_type>) {
+				if (packed) {
+					return packed_q8_0_layout::get_total_bytes(row_count, block_count);
+				}
+			}
+			return type_traits<output_type>::total_byte_size(base_type::dims);
+		}
+
+		NIHILUS_FORCE_INLINE static void impl(base_type& core, bool packed, std::vector<weight_range>& ranges) {
+			if constexpr (base_type::total_required_bytes == 0 && base_type::krn_type == kernel_type::none) {
+				if constexpr (array_type<decltype(core.data)>) {
+					for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
+						if (core.data[x]) {
+							ranges.emplace_back(
+								weight_range{ reinterpret_cast<const uint8_t*>(core.data[x]), reinterpret_cast<void**>(&core.data[x]), get_byte_count(packed), x, true });
+						}
+					}
+				} else if (core.data) {
+					ranges.emplace_back(
+						weight_range{ reinterpret_cast<const uint8_t*>(core.data), reinterpret_cast<void**>(&core.data), get_byte_count(packed), consumption_block });
+				}
+			}
+		}
+	};
+
+	struct numa_weight_range {
+		const uint8_t* data{};
+		uint64_t size{};
+		uint64_t node{};
+	};
+
+	// Splits every weight tensor into the row ranges each node's workers consume under the current partition; the model then binds or first-touches
+	// each range from that node.
+	template<typename base_type> struct numa_weight_binder {
+		NIHILUS_FORCE_INLINE numa_weight_binder() noexcept									   = default;
+		NIHILUS_FORCE_INLINE numa_weight_binder& operator=(const numa_weight_binder&) noexcept = delete;
+		NIHILUS_FORCE_INLINE numa_weight_binder(const numa_weight_binder&) noexcept			   = delete;
+		NIHILUS_FORCE_INLINE numa_weight_binder& operator=(numa_weight_binder&&) noexcept	   = delete;
+		NIHILUS_FORCE_INLINE numa_weight_binder(numa_weight_binder&&) noexcept				   = delete;
+		static constexpr uint64_t row_count{ base_type::dims[1] * base_type::dims[2] * base_type::dims[3] };
+		static constexpr uint64_t row_bytes{ base_type::strides[1] };
+		static constexpr uint64_t block_count{ base_type::dims[0] / Q_SIZE };
+
+		NIHILUS_FORCE_INLINE static uint64_t get_row_offset(uint64_t row, bool packed) noexcept {
+			if constexpr (is_packable_weight<base_type>) {
+				if (packed) {
+					return packed_q8_0_layout::get_row_offset(row, block_count);
+				}
+			}
+			return row * row_bytes;
+		}
+
+		NIHILUS_FORCE_INLINE static void collect_rows(const void* ptr, const numa_topology& topology, uint64_t thread_count, const work_partition& partition, bool packed,
+			std::vector<numa_weight_range>& ranges) {
+			if (!ptr) {
+				return;
+			}
+			const uint64_t granularity = is_packable_weight<base_type> && packed ? packed_q8_0_layout::rows_per_group : 1;
+			for (uint64_t x = 0; x < topology.node_count(); ++x) {
+				const row_range threads = topology.get_node_thread_range(x, thread_count);
+				if (threads.first >= threads.last) {
+					continue;
+				}
+				const uint64_t first_row = partition.get_range(threads.first, thread_count, row_count, granularity).first;
+				const uint64_t last_row	 = partition.get_range(threads.last - 1, thread_count, row_count, granularity).last;
+				const uint64_t first	 = get_row_offset(first_row, packed);
+				const uint64_t size		 = (last_row == row_count ? get_row_offset(round_up_to_multiple(row_count, granularity), packed) : get_row_offset(last_row, packed)) - first;
+				ranges.emplace_back(numa_weight_range{ static_cast<const uint8_t*>(ptr) + first, size, x });
+			}
+		}
+
+		NIHILUS_FORCE_INLINE static void impl(base_type& core, const numa_topology& topology, uint64_t thread_count, const work_partition& partition, bool packed,
+			std::vector<numa_weight_range>& ranges) {
+			if constexpr (base_type::total_required_bytes == 0 && base_type::krn_type == kernel_type::none) {
+				if constexpr (array_type<decltype(core.data)>) {
+					for (uint64_t x = 0; x < base_type::model_traits_type::block_count; ++x) {
+						collect_rows(core.data[x], topology, thread_count, partition, packed, ranges);
+					}
+				} else {
+					collect_rows(core.data, topology, thread_count, partition, packed, ranges);
+				}
+			}
+		}
+	};
+
 	template<model_config config, typename base_type_new> struct thread_function : public base_type_new {
 		NIHILUS_FORCE_INLINE thread_function() noexcept									 = default;
 		NIHILUS_FORCE_INLINE thread_function& operator=(const thread_function&) noexcept = delete;
@@ -294,9 +461,9 @@ namespace nihilus {
 		NIHILUS_FORCE_INLINE thread_function(thread_function&&) noexcept				 = delete;
 		using output_type																 = base_type_new::output_type;
 		using base_type																	 = base_type_new;
-		NIHILUS_FORCE_INLINE void thread_impl(uint64_t thread_index, uint64_t thread_count) {
+		NIHILUS_FORCE_INLINE void thread_impl(uint64_t thread_index, uint64_t thread_count, const work_partition& partition) {
 			if constexpr (active_thread<base_type>) {
-				kernel_dispatcher<config, device_type::cpu, base_type>::impl(*this, thread_index, thread_count);
+				kernel_dispatcher<config, device_type::cpu, base_type>::impl(*this, thread_index, thread_count, partition);
 				spinlock_nanoseconds(500);
 			}
 		}
@@ -311,9 +478,12 @@ namespace nihilus {
 		NIHILUS_FORCE_INLINE thread_function(thread_function&&) noexcept				 = delete;
 		using output_type																 = base_type_new::output_type;
 		using base_type																	 = base_type_new;
-		NIHILUS_FORCE_INLINE void thread_impl(uint64_t thread_index, uint64_t thread_count, uint64_t current_index = 0) {
+		NIHILUS_FORCE_INLINE void thread_impl(uint64_t thread_index, uint64_t thread_count, const work_partition& partition, uint64_t current_index = 0) {
 			this->sync_flag_start[current_index].arrive_and_wait(thread_index);
-			kernel_dispatcher<config, device_type::cpu, base_type>::impl(*this, thread_index, thread_count);
+			kernel_dispatcher<config, device_type::cpu, base_type>::impl(*this, thread_index, thread_count, partition);
+			if constexpr (requires(base_type& core) { core.selector; }) {
+				this->selector.template reduce<packed_q8_0_layout::rows_per_group>(thread_index, thread_count, partition, this->data, base_type::dims[0]);
+			}
 			spinlock_nanoseconds(500);
 			this->sync_flag_end[current_index].arrive_and_wait(thread_index);
 		}
@@ -369,49 +539,53 @@ namespace nihilus {
 		}() };
 
 		template<template<model_config, typename> typename thread_function, uint64_t current_index = 0>
-		NIHILUS_FORCE_INLINE void impl_global_input(uint64_t thread_index, uint64_t thread_count) {
+		NIHILUS_FORCE_INLINE void impl_global_input(uint64_t thread_index, uint64_t thread_count, const work_partition& partition) {
 			if constexpr (current_index < global_input_count) {
 				static constexpr op_type_type op_type = global_input[current_index];
 				using core_traits_type				  = core_traits<config, op_type>;
 				static_cast<thread_function<config, core_traits_type>*>(static_cast<core_traits_type*>(static_cast<derived_type_new*>(this)))
-					->thread_impl(thread_index, thread_count);
-				impl_global_input<thread_function, current_index + 1>(thread_index, thread_count);
+					->thread_impl(thread_index, thread_count, partition);
+				impl_global_input<thread_function, current_index + 1>(thread_index, thread_count, partition);
 			}
 		}
 
 		template<template<model_config, typename> typename thread_function, uint64_t current_index = 0>
-		NIHILUS_FORCE_INLINE void impl_per_block(uint64_t thread_index, uint64_t thread_count, uint64_t current_index_new) {
+		NIHILUS_FORCE_INLINE void impl_per_block(uint64_t thread_index, uint64_t thread_count, const work_partition& partition, uint64_t current_index_new) {
 			if constexpr (current_index < per_block_count) {
 				static constexpr op_type_type op_type = per_block[current_index];
 				using core_traits_type				  = core_traits<config, op_type>;
 				if constexpr (blocking<core_traits_type>) {
 					static_cast<thread_function<config, core_traits_type>*>(static_cast<core_traits_type*>(static_cast<derived_type_new*>(this)))
-						->thread_impl(thread_index, thread_count, current_index_new);
+						->thread_impl(thread_index, thread_count, partition, current_index_new);
 				} else {
 					static_cast<thread_function<config, core_traits_type>*>(static_cast<core_traits_type*>(static_cast<derived_type_new*>(this)))
-						->thread_impl(thread_index, thread_count);
+						->thread_impl(thread_index, thread_count, partition);
 				}
-				impl_per_block<thread_function, current_index + 1>(thread_index, thread_count, current_index_new);
+				impl_per_block<thread_function, current_index + 1>(thread_index, thread_count, partition, current_index_new);
 			}
 		}
 
 		template<template<model_config, typename> typename thread_function, uint64_t current_index = 0>
-		NIHILUS_FORCE_INLINE void impl_global_output(uint64_t thread_index, uint64_t thread_count) {
+		NIHILUS_FORCE_INLINE void impl_global_output(uint64_t thread_index, uint64_t thread_count, const work_partition& partition) {
 			if constexpr (current_index < global_output_count) {
 				static constexpr op_type_type op_type = global_output[current_index];
 				using core_traits_type				  = core_traits<config, op_type>;
 				static_cast<thread_function<config, core_traits_type>*>(static_cast<core_traits_type*>(static_cast<derived_type_new*>(this)))
-					->thread_impl(thread_index, thread_count);
-				impl_global_output<thread_function, current_index + 1>(thread_index, thread_count);
+					->thread_impl(thread_index, thread_count, partition);
+				impl_global_output<thread_function, current_index + 1>(thread_index, thread_count, partition);
 			}
 		};
 
-		template<template<model_config, typename> typename thread_function> NIHILUS_FORCE_INLINE void impl(uint64_t thread_index, uint64_t thread_count) {
-			impl_global_input<thread_function>(thread_index, thread_count);
+		template<template<model_config, typename> typename thread_function>
+		NIHILUS_FORCE_INLINE void impl(uint64_t thread_index, uint64_t thread_count, const work_partition& partition) {
+			impl_global_input<thread_function>(thread_index, thread_count, partition);
 			for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
-				impl_per_block<thread_function>(thread_index, thread_count, x);
+				if constexpr (requires(derived_type_new& derived, uint64_t index, uint64_t block) { derived.on_block_worker(index, block); }) {
+					static_cast<derived_type_new*>(this)->on_block_worker(thread_index, x);
+				}
+				impl_per_block<thread_function>(thread_index, thread_count, partition, x);
 			}
-			impl_global_output<thread_function>(thread_index, thread_count);
+			impl_global_output<thread_function>(thread_index, thread_count, partition);
 		}
 
 		template<template<model_config, typename> typename thread_function, uint64_t current_index = 0> NIHILUS_FORCE_INLINE void impl_global_output_main() {
@@ -438,6 +612,9 @@ namespace nihilus {
 
 		template<template<model_config, typename> typename thread_function> NIHILUS_FORCE_INLINE void impl_main() {
 			for (uint64_t x = 0; x < model_traits_type::block_count; ++x) {
+				if constexpr (requires(derived_type_new& derived, uint64_t block) { derived.on_block_main(block); }) {
+					static_cast<derived_type_new*>(this)->on_block_main(x);
+				}
 				impl_per_block_main<thread_function>(x);
 			}
 			impl_global_output_main<thread_function>();
@@ -450,34 +627,164 @@ namespace nihilus {
 		NIHILUS_FORCE_INLINE thread_pool& operator=(const thread_pool&) noexcept = delete;
 		NIHILUS_FORCE_INLINE thread_pool(const thread_pool&) noexcept			 = delete;
 
-		NIHILUS_FORCE_INLINE thread_pool(uint64_t thread_count_new) {
+		NIHILUS_FORCE_INLINE thread_pool(const cli_params& params) {
+			const uint64_t thread_count_new{ params.thread_count };
 			threads.resize(thread_count_new);
 			thread_count = thread_count_new;
 			thread_latch.init(thread_count_new);
+			if (params.numa) {
+				numa.init();
+			}
+			plan_thread_placement(params);
+			calibrate_threads = params.calibrate || params.placement != thread_placement::none || numa.is_active();
+			thread_capacity.assign(thread_count_new, 0.0);
+			calibration_arrivals.store(0, std::memory_order_release);
+			calibration_pending.store(calibrate_threads ? thread_count_new : 0, std::memory_order_release);
 			for (uint64_t x = 0; x < thread_count_new; ++x) {
-				threads[x] = std::thread{ [&, x] {
-					if (x < (thread_count_new % 3) == 0) {
+				threads[x] = std::thread{ [&, x, raise_priority = params.high_priority] {
+					if (raise_priority) {
 						thread_function_impl<true>(x);
 					} else {
 						thread_function_impl<false>(x);
 					}
 				} };
 			}
+			if (calibrate_threads) {
+				finish_calibration();
+			}
 		}
 
 		template<bool raise_priority> NIHILUS_FORCE_INLINE void thread_function_impl(uint64_t thread_index) {
-			if (thread_index % 2 == 0) {
-				//pin_thread_to_core(thread_index % 2);
+			if (!thread_cpus[thread_index].empty()) {
+				pin_thread_to_cpu_set(thread_cpus[thread_index]);
+			}
+			if constexpr (raise_priority) {
+				raise_current_thread_priority();
+			}
+			if (calibrate_threads) {
+				calibration_arrivals.fetch_add(1, std::memory_order_acq_rel);
+				while (calibration_arrivals.load(std::memory_order_acquire) < thread_count) {
+					nihilus_pause();
+				}
+				thread_capacity[thread_index] = measure_thread_capacity();
+				calibration_pending.fetch_sub(1, std::memory_order_acq_rel);
+				calibration_pending.notify_one();
 			}
 			while (!stop.load(std::memory_order_acquire)) {
 				thread_latch.worker_wait(thread_index);
 				if (!stop.load(std::memory_order_acquire)) {
-					threading_strategy<config, derived_type>::template impl<thread_function>(thread_index, thread_count);
+					if (worker_task) {
+						worker_task(thread_index, thread_count);
+					} else {
+						threading_strategy<config, derived_type>::template impl<thread_function>(thread_index, thread_count, partition);
+					}
 					thread_latch.arrive_and_wait(thread_index);
 				}
 			}
 		}
 
+		// All workers run the same short fma loop at the same time on their final cpus, so SMT sharing and hybrid core speeds show up in the result.
+		NIHILUS_FORCE_INLINE static double measure_thread_capacity() {
+			static constexpr uint64_t element_count{ 1024 };
+			static constexpr uint64_t iteration_count{ 256 };
+			alignas(64) array<float, element_count> values{};
+			for (uint64_t x = 0; x < element_count; ++x) {
+				values[x] = static_cast<float>(x) * 0.001f;
+			}
+			array<float, 8> accumulators{};
+			double best{};
+			for (uint64_t x = 0; x < 5; ++x) {
+				const auto start = std::chrono::steady_clock::now();
+				for (uint64_t y = 0; y < iteration_count; ++y) {
+					for (uint64_t z = 0; z < element_count; z += 8) {
+						for (uint64_t w = 0; w < 8; ++w) {
+							accumulators[w] = accumulators[w] * 0.999f + values[z + w];
+						}
+					}
+				}
+				const double elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+				best				 = std::max(best, static_cast<double>(element_count * iteration_count) / std::max(elapsed, 1.0));
+			}
+			volatile float sink{ accumulators[0] + accumulators[7] };
+			( void )sink;
+			return best;
+		}
+
+		NIHILUS_FORCE_INLINE void finish_calibration() {
+			uint64_t pending = calibration_pending.load(std::memory_order_acquire);
+			while (pending > 0) {
+				calibration_pending.wait(pending, std::memory_order_acquire);
+				pending = calibration_pending.load(std::memory_order_acquire);
+			}
+			partition.set_capacities(thread_capacity);
+			const double fastest = *std::max_element(thread_capacity.begin(), thread_capacity.end());
+			const std::vector<uint32_t> atom_cpus{ get_hybrid_core_cpus("cpu_atom") };
+			uint64_t atom_threads{};
+			std::string summary{};
+			for (uint64_t x = 0; x < thread_count; ++x) {
+				summary += (x > 0 ? "," : "") + std::to_string(static_cast<uint64_t>(thread_capacity[x] / fastest * 100.0));
+				if (thread_cpus[x].size() == 1 && std::find(atom_cpus.begin(), atom_cpus.end(), thread_cpus[x].front()) != atom_cpus.end()) {
+					++atom_threads;
+				}
+			}
+			log<log_level::status>("thread_pool: calibrated relative capacity (%): " + summary);
+			if (atom_threads > 0) {
+				log<log_level::status>("thread_pool: " + std::to_string(atom_threads) + " workers are pinned to efficiency cores.");
+			}
+		}
+
+		// Each worker is pinned to a single cpu from the ordered placement list; when numa is active the list is filtered per node so a thread
+		// never leaves the node that holds its weight rows (without a placement list it floats over all of its node's cpus).
+		NIHILUS_FORCE_INLINE void plan_thread_placement(const cli_params& params) {
+			thread_cpus.clear();
+			thread_cpus.resize(thread_count);
+			std::vector<uint32_t> ordered{};
+			if (params.placement == thread_placement::explicit_list) {
+				ordered = parse_cpu_list(params.cpu_list);
+			} else if (params.placement != thread_placement::none) {
+				cpu_topology topology{};
+				topology.init();
+				ordered = topology.get_ordered_cpus(params.placement, params.use_smt);
+			}
+			if (numa.is_active()) {
+				for (uint64_t x = 0; x < numa.node_count(); ++x) {
+					const auto& node_cpus		 = numa.get_node(x).cpus;
+					const row_range node_threads = numa.get_node_thread_range(x, thread_count);
+					std::vector<uint32_t> local{};
+					for (uint32_t cpu: ordered) {
+						if (std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end()) {
+							local.emplace_back(cpu);
+						}
+					}
+					for (uint64_t y = node_threads.first; y < node_threads.last; ++y) {
+						thread_cpus[y] = local.empty() ? node_cpus : std::vector<uint32_t>{ local[(y - node_threads.first) % local.size()] };
+					}
+				}
+			} else if (!ordered.empty()) {
+				for (uint64_t x = 0; x < thread_count; ++x) {
+					thread_cpus[x] = { ordered[x % ordered.size()] };
+				}
+				if (ordered.size() < thread_count) {
+					log<log_level::status>("thread_pool: " + std::to_string(thread_count) + " threads share " + std::to_string(ordered.size()) + " placement cpus.");
+				}
+			}
+			if (!ordered.empty()) {
+				std::string summary{};
+				for (uint64_t x = 0; x < thread_count; ++x) {
+					summary += (x > 0 ? "," : "") + std::to_string(thread_cpus[x].empty() ? 0 : thread_cpus[x].front());
+				}
+				log<log_level::status>("thread_pool: pinned workers to cpus " + summary);
+			}
+		}
+
+		// Runs task(thread_index, thread_count) on every worker in place of the graph (load-time work such as page-in) and returns once all are done.
+		NIHILUS_FORCE_INLINE void run_on_workers(std::function<void(uint64_t, uint64_t)> task) {
+			worker_task = std::move(task);
+			thread_latch.count_down();
+			thread_latch.main_wait();
+			worker_task = nullptr;
+		}
+
 		NIHILUS_FORCE_INLINE void execute_tasks() {
 			thread_latch.count_down();
 			threading_strategy<config, derived_type>::template impl_main<thread_function>();
@@ -495,6 +802,14 @@ namespace nihilus {
 		};
 
 	  protected:
+		std::function<void(uint64_t, uint64_t)> worker_task{};
+		std::vector<std::vector<uint32_t>> thread_cpus{};
+		std::atomic<uint64_t> calibration_arrivals{};
+		std::atomic<uint64_t> calibration_pending{};
+		std::vector<double> thread_capacity{};
+		work_partition partition{};
+		bool calibrate_threads{};
+		numa_topology numa{};
 		std::vector<std::thread> threads{};
 		char padding[32]{};
 		alignas(64) std::atomic_bool stop{};
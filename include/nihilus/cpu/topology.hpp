@@ -0,0 +1,304 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+#pragma once
+
+#include <nihilus/common/allocator.hpp>
+#include <nihilus/common/common.hpp>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(NIHILUS_PLATFORM_LINUX)
+	#include <sys/syscall.h>
+	#include <pthread.h>
+	#include <unistd.h>
+	#include <sched.h>
+#endif
+
+namespace nihilus {
+
+	struct row_range {
+		uint64_t first{};
+		uint64_t last{};
+	};
+
+	// Static split of [0, total) across the workers, weighted by each worker's measured capacity (see thread_pool::calibrate) so that on hybrid parts
+	// the slow cores do not set the barrier time; boundaries are kept on multiples of granularity (e.g. interleaved row groups).
+	struct work_partition {
+		static constexpr uint64_t weight_scale{ 1ull << 20 };
+
+		NIHILUS_FORCE_INLINE void set_capacities(const std::vector<double>& capacities) {
+			double total_capacity{};
+			for (double value: capacities) {
+				total_capacity += value;
+			}
+			if (capacities.empty() || !(total_capacity > 0.0)) {
+				prefix.clear();
+				return;
+			}
+			prefix.resize(capacities.size() + 1);
+			prefix[0] = 0;
+			double running{};
+			for (uint64_t x = 0; x < capacities.size(); ++x) {
+				running += capacities[x];
+				prefix[x + 1] = static_cast<uint64_t>(running / total_capacity * static_cast<double>(weight_scale));
+			}
+			prefix.back() = weight_scale;
+		}
+
+		NIHILUS_FORCE_INLINE void reset() noexcept {
+			prefix.clear();
+		}
+
+		NIHILUS_FORCE_INLINE bool is_weighted(uint64_t thread_count) const noexcept {
+			return prefix.size() == thread_count + 1;
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t get_boundary(uint64_t thread_index, uint64_t thread_count, uint64_t units) const noexcept {
+			if (is_weighted(thread_count)) {
+				return units * prefix[thread_index] / weight_scale;
+			}
+			return units * thread_index / thread_count;
+		}
+
+		NIHILUS_FORCE_INLINE row_range get_range(uint64_t thread_index, uint64_t thread_count, uint64_t total, uint64_t granularity = 1) const noexcept {
+			const uint64_t units = (total + granularity - 1) / granularity;
+			const uint64_t first = std::min(get_boundary(thread_index, thread_count, units) * granularity, total);
+			const uint64_t last	 = thread_index + 1 == thread_count ? total : std::min(get_boundary(thread_index + 1, thread_count, units) * granularity, total);
+			return { first, last };
+		}
+
+	  protected:
+		std::vector<uint64_t> prefix{};
+	};
+
+	NIHILUS_FORCE_INLINE constexpr uint32_t parse_cpu_index(std::string_view str) noexcept {
+		uint32_t result = 0;
+		for (char c: str) {
+			if (c < '0' || c > '9') {
+				break;
+			}
+			result = result * 10 + static_cast<uint32_t>(c - '0');
+		}
+		return result;
+	}
+
+	// Parses the kernel's cpulist format, e.g. "0-3,8,10-11".
+	NIHILUS_FORCE_INLINE std::vector<uint32_t> parse_cpu_list(std::string_view list) {
+		std::vector<uint32_t> return_value{};
+		while (!list.empty()) {
+			const uint64_t comma = list.find(',');
+			std::string_view entry{ list.substr(0, comma) };
+			list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+			while (!entry.empty() && (entry.back() == '\n' || entry.back() == ' ')) {
+				entry.remove_suffix(1);
+			}
+			if (entry.empty()) {
+				continue;
+			}
+			const uint64_t dash = entry.find('-');
+			const uint32_t first{ parse_cpu_index(entry.substr(0, dash)) };
+			const uint32_t last{ dash == std::string_view::npos ? first : parse_cpu_index(entry.substr(dash + 1)) };
+			for (uint32_t x = first; x <= last; ++x) {
+				return_value.emplace_back(x);
+			}
+		}
+		return return_value;
+	}
+
+	NIHILUS_FORCE_INLINE std::string read_sysfs_line(const std::filesystem::path& path) {
+		std::ifstream stream{ path };
+		std::string line{};
+		std::getline(stream, line);
+		return line;
+	}
+
+	NIHILUS_FORCE_INLINE bool pin_thread_to_cpu_set(const std::vector<uint32_t>& cpus) {
+#if defined(NIHILUS_PLATFORM_LINUX)
+		if (cpus.empty()) {
+			return false;
+		}
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		for (uint32_t cpu: cpus) {
+			CPU_SET(cpu, &cpuset);
+		}
+		int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+		if (result != 0) {
+			std::cerr << "Failed to set thread affinity on Linux. Error: " << result << std::endl;
+			return false;
+		}
+		return true;
+#else
+		( void )cpus;
+		return false;
+#endif
+	}
+
+	struct cpu_info {
+		uint32_t package_id{};
+		uint32_t core_id{};
+		uint32_t l3_id{};
+		bool primary{};
+		uint32_t id{};
+	};
+
+	struct cpu_topology {
+		NIHILUS_FORCE_INLINE void init() {
+			cpus.clear();
+#if defined(NIHILUS_PLATFORM_LINUX)
+			const std::filesystem::path cpu_root{ "/sys/devices/system/cpu" };
+			for (uint32_t cpu_id: parse_cpu_list(read_sysfs_line(cpu_root / "online"))) {
+				const std::filesystem::path cpu_path{ cpu_root / ("cpu" + std::to_string(cpu_id)) };
+				cpu_info cpu{};
+				cpu.id		   = cpu_id;
+				cpu.core_id	   = parse_cpu_index(read_sysfs_line(cpu_path / "topology" / "core_id"));
+				cpu.package_id = parse_cpu_index(read_sysfs_line(cpu_path / "topology" / "physical_package_id"));
+				const std::vector<uint32_t> siblings{ parse_cpu_list(read_sysfs_line(cpu_path / "topology" / "thread_siblings_list")) };
+				cpu.primary = siblings.empty() || siblings.front() == cpu_id;
+				const std::vector<uint32_t> l3_shared{ parse_cpu_list(read_sysfs_line(cpu_path / "cache" / "index3" / "shared_cpu_list")) };
+				cpu.l3_id = l3_shared.empty() ? cpu.package_id : l3_shared.front();
+				cpus.emplace_back(cpu);
+			}
+#endif
+		}
+
+		// Physical cores come before SMT siblings (which are only included when allowed); with l3 ordering the cpus are grouped by last-level cache
+		// first, so neighbouring thread indices - which also own neighbouring row ranges - stay within one CCX.
+		NIHILUS_FORCE_INLINE std::vector<uint32_t> get_ordered_cpus(thread_placement placement, bool use_smt) const {
+			std::vector<cpu_info> ordered{ cpus };
+			std::stable_sort(ordered.begin(), ordered.end(), [&](const cpu_info& lhs, const cpu_info& rhs) {
+				if (placement == thread_placement::l3 && lhs.l3_id != rhs.l3_id) {
+					return lhs.l3_id < rhs.l3_id;
+				}
+				if (lhs.primary != rhs.primary) {
+					return lhs.primary;
+				}
+				if (lhs.package_id != rhs.package_id) {
+					return lhs.package_id < rhs.package_id;
+				}
+				return lhs.core_id < rhs.core_id;
+			});
+			std::vector<uint32_t> return_value{};
+			for (const auto& cpu: ordered) {
+				if (cpu.primary || use_smt) {
+					return_value.emplace_back(cpu.id);
+				}
+			}
+			return return_value;
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t physical_core_count() const noexcept {
+			return static_cast<uint64_t>(std::count_if(cpus.begin(), cpus.end(), [](const cpu_info& cpu) {
+				return cpu.primary;
+			}));
+		}
+
+	  protected:
+		std::vector<cpu_info> cpus{};
+	};
+
+	// Intel hybrid parts expose their P-cores and E-cores as separate PMUs.
+	NIHILUS_FORCE_INLINE std::vector<uint32_t> get_hybrid_core_cpus(std::string_view pmu_name) {
+#if defined(NIHILUS_PLATFORM_LINUX)
+		return parse_cpu_list(read_sysfs_line(std::filesystem::path{ "/sys/devices" } / pmu_name / "cpus"));
+#else
+		( void )pmu_name;
+		return {};
+#endif
+	}
+
+	struct numa_node {
+		std::vector<uint32_t> cpus{};
+		uint32_t id{};
+	};
+
+	struct numa_topology {
+		static constexpr int mpol_bind{ 2 };
+		static constexpr unsigned mpol_mf_move{ 1u << 1 };
+
+		NIHILUS_FORCE_INLINE void init() {
+			nodes.clear();
+#if defined(NIHILUS_PLATFORM_LINUX)
+			const std::filesystem::path node_root{ "/sys/devices/system/node" };
+			for (uint32_t node_id: parse_cpu_list(read_sysfs_line(node_root / "online"))) {
+				numa_node node{};
+				node.id	  = node_id;
+				node.cpus = parse_cpu_list(read_sysfs_line(node_root / ("node" + std::to_string(node_id)) / "cpulist"));
+				if (!node.cpus.empty()) {
+					nodes.emplace_back(std::move(node));
+				}
+			}
+#endif
+			if (nodes.size() > 1) {
+				log<log_level::status>("numa_topology: " + std::to_string(nodes.size()) + " nodes with cpus detected.");
+			}
+		}
+
+		NIHILUS_FORCE_INLINE bool is_active() const noexcept {
+			return nodes.size() > 1;
+		}
+
+		NIHILUS_FORCE_INLINE uint64_t node_count() const noexcept {
+			return nodes.size();
+		}
+
+		NIHILUS_FORCE_INLINE const numa_node& get_node(uint64_t index) const noexcept {
+			return nodes[index];
+		}
+
+		// Threads are assigned to nodes in contiguous groups, so the rows each node's threads consume (see work_partition) are contiguous too.
+		NIHILUS_FORCE_INLINE uint64_t get_thread_node(uint64_t thread_index, uint64_t thread_count) const noexcept {
+			return thread_index * nodes.size() / thread_count;
+		}
+
+		NIHILUS_FORCE_INLINE row_range get_node_thread_range(uint64_t node_index, uint64_t thread_count) const noexcept {
+			const uint64_t node_total = nodes.size();
+			return { (node_index * thread_count + node_total - 1) / node_total, ((node_index + 1) * thread_count + node_total - 1) / node_total };
+		}
+
+		NIHILUS_FORCE_INLINE bool bind_range(const void* address, uint64_t size, uint64_t node_index) const noexcept {
+#if defined(NIHILUS_PLATFORM_LINUX) && defined(SYS_mbind)
+			static const uint64_t page_size{ static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) };
+			const uintptr_t first = round_up_to_multiple(reinterpret_cast<uintptr_t>(address), page_size);
+			const uintptr_t last  = (reinterpret_cast<uintptr_t>(address) + size) & ~(page_size - 1);
+			if (last <= first) {
+				return false;
+			}
+			const uint32_t node_id = nodes[node_index].id;
+			array<unsigned long, 16> mask{};
+			mask[node_id / (8 * sizeof(unsigned long))] |= 1ul << (node_id % (8 * sizeof(unsigned long)));
+			return syscall(SYS_mbind, first, last - first, mpol_bind, mask.data(), mask.size() * 8 * sizeof(unsigned long), mpol_mf_move) == 0;
+#else
+			( void )address;
+			( void )size;
+			( void )node_index;
+			return false;
+#endif
+		}
+
+	  protected:
+		std::vector<numa_node> nodes{};
+	};
+
+}
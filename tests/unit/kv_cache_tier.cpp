@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+
+#include <nihilus/index.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Writes every position of a short context through the page table in prefill-sized chunks, with a hot tier far smaller than the context, and
+// checks that each chunk lands in the hot tier and that every position written so far reads back through the page table - pages spilled to the
+// cold tier included. Then checks that prefetch advises each spilled page once per block.
+
+static constexpr auto test_config = nihilus::generate_model_config(nihilus::llama_model_generation::v3, nihilus::llama_model_size::llama_1B,
+	nihilus::kernel_type_profile::q8_gqa, nihilus::model_arch::llama, false, nihilus::kv_cache_strategy::hierarchical);
+
+using tier_type			= nihilus::kv_cache_tier<test_config>;
+using model_traits_type	= tier_type::model_traits_type;
+using kv_cache_type		= tier_type::kv_cache_type;
+
+static constexpr uint64_t context_length{ 256 };
+static constexpr uint64_t batch_token_count{ 40 };
+static constexpr uint64_t hot_page_capacity{ 8 };
+static constexpr uint64_t row_element_count{ model_traits_type::head_count_kv * model_traits_type::head_dim };
+static constexpr uint64_t row_bytes{ row_element_count * sizeof(kv_cache_type) };
+
+static uint8_t row_pattern(uint64_t block, uint64_t kind, uint64_t position) {
+	return static_cast<uint8_t>(block * 31 + kind * 7 + position + 1);
+}
+
+static kv_cache_type* row_ptr(tier_type& tier, uint64_t block, uint64_t kind, uint64_t position) {
+	return tier.get_page_table(block, static_cast<nihilus::kv_cache_kind>(kind))[position / tier_type::page_token_count] +
+		(position % tier_type::page_token_count) * row_element_count;
+}
+
+static bool check_rows(tier_type& tier, uint64_t end) {
+	std::vector<uint8_t> expected(row_bytes);
+	for (uint64_t x = 0; x < tier_type::kind_count; ++x) {
+		for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+			for (uint64_t z = 0; z < end; ++z) {
+				std::memset(expected.data(), row_pattern(y, x, z), row_bytes);
+				if (std::memcmp(row_ptr(tier, y, x, z), expected.data(), row_bytes) != 0) {
+					std::cout << "kv_cache_tier: position " << z << " of block " << y << " kind " << x << " did not survive the round trip." << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	std::vector<std::vector<uint8_t>> hot_buffers(tier_type::kind_count * model_traits_type::block_count);
+	nihilus::array<nihilus::array<void*, model_traits_type::block_count>, tier_type::kind_count> hot_storage{};
+	for (uint64_t x = 0; x < tier_type::kind_count; ++x) {
+		for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+			auto& buffer = hot_buffers[x * model_traits_type::block_count + y];
+			buffer.resize(hot_page_capacity * tier_type::page_bytes);
+			hot_storage[x][y] = buffer.data();
+		}
+	}
+
+	{
+		tier_type tier{};
+		if (tier.init("", context_length, 1, context_length, hot_page_capacity * tier_type::page_bytes, hot_storage)) {
+			std::cout << "kv_cache_tier: accepted a batch that does not fit in the hot tier." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	tier_type tier{};
+	if (!tier.init("", context_length, 1, batch_token_count, hot_page_capacity * tier_type::page_bytes, hot_storage)) {
+		std::cout << "kv_cache_tier: failed to initialize." << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (tier.get_batch_capacity() < batch_token_count) {
+		std::cout << "kv_cache_tier: the hot tier was not raised to cover a " << batch_token_count << " token batch." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (uint64_t begin = 0; begin < context_length; begin += batch_token_count) {
+		const uint64_t end = std::min(begin + batch_token_count, context_length);
+		tier.advance(end - 1);
+		tier.prefetch(0);
+		for (uint64_t x = 0; x < tier_type::kind_count; ++x) {
+			for (uint64_t y = 0; y < model_traits_type::block_count; ++y) {
+				const uint8_t* hot_begin = hot_buffers[x * model_traits_type::block_count + y].data();
+				const uint8_t* hot_end	 = hot_begin + hot_page_capacity * tier_type::page_bytes;
+				for (uint64_t z = begin; z < end; ++z) {
+					const uint8_t* row = reinterpret_cast<const uint8_t*>(row_ptr(tier, y, x, z));
+					if (row < hot_begin || row + row_bytes > hot_end) {
+						std::cout << "kv_cache_tier: position " << z << " was spilled before it was written." << std::endl;
+						return EXIT_FAILURE;
+					}
+					std::memset(row_ptr(tier, y, x, z), row_pattern(y, x, z), row_bytes);
+				}
+			}
+		}
+		if (!check_rows(tier, end)) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Block 0 was prefetched after every chunk and block 1 never, so between them each spilled page has been advised exactly twice; a repeat call
+	// has nothing new to advise.
+	const uint64_t cold_bytes = tier.first_hot_page() * tier_type::page_bytes * tier_type::kind_count;
+	tier.prefetch(1);
+	const nihilus::kv_cache_stats prefetched{ tier.get_stats() };
+	tier.prefetch(0);
+	tier.prefetch(1);
+	if (tier.get_stats().prefetches != prefetched.prefetches || prefetched.bytes_prefetched != cold_bytes * 2) {
+		std::cout << "kv_cache_tier: prefetched " << prefetched.bytes_prefetched << " bytes, expected " << cold_bytes * 2 << "." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (tier.fetch(0, nihilus::kv_cache_kind::key, 0) != tier.get_page_table(0, nihilus::kv_cache_kind::key)[0] ||
+		tier.fetch(0, nihilus::kv_cache_kind::value, tier.first_hot_page()) != tier.get_page_table(0, nihilus::kv_cache_kind::value)[tier.first_hot_page()]) {
+		std::cout << "kv_cache_tier: fetch disagrees with the page table." << std::endl;
+		return EXIT_FAILURE;
+	}
+	tier.log_stats();
+	const nihilus::kv_cache_stats stats{ tier.get_stats() };
+	if (stats.spills == 0 || stats.cold_fetches != 1 || stats.hot_fetches != 1) {
+		std::cout << "kv_cache_tier: expected spills, one hot fetch and one cold fetch." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "kv_cache_tier: " << context_length << " positions round-tripped through " << stats.spills << " spills." << std::endl;
+	return EXIT_SUCCESS;
+}
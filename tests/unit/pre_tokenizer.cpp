@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2025 RealTimeChris (Chris M.)
+
+This file is part of software offered under a restricted-use license to a designated Licensee,
+whose identity is confirmed in writing by the Author.
+
+License Terms (Summary):
+- Exclusive, non-transferable license for internal use only.
+- Redistribution, sublicensing, or public disclosure is prohibited without written consent.
+- Full ownership remains with the Author.
+- License may terminate if unused for [X months], if materially breached, or by mutual agreement.
+- No warranty is provided, express or implied.
+
+Full license terms are provided in the LICENSE file distributed with this software.
+
+Signed,
+RealTimeChris (Chris M.)
+2025
+*/
+
+
+#include <nihilus/index.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Fuzzes the llama-3 pre-tokenizer against the pattern it implements, run through std::wregex with \p{L}, \p{N} and \s spelled out over the code
+// points the generator draws from, and checks classify_ascii_block byte by byte against ascii_classes. Only the classification path selected by
+// NIHILUS_CPU_INSTRUCTIONS is compiled in, so configuring with 0 (scalar), 1 (AVX2) and 4 (NEON) pins each one.
+
+struct tokenizer_probe : public nihilus::tokenizer<nihilus::model_arch::llama> {
+	using tokenizer::split_words;
+};
+
+static constexpr const wchar_t* letters{ L"A-Za-z\\u00C9\\u00E9\\u0430\\u4E2D" };
+static constexpr const wchar_t* numbers{ L"0-9\\u0663" };
+static constexpr const wchar_t* whitespace{ L"\\t\\n\\v\\f\\r \\u00A0\\u2003\\u3000" };
+
+static const std::vector<std::vector<char32_t>> code_point_classes{
+	{ U'a', U'e', U'k', U's', U't', U'z', U'A', U'L', U'R', U'S', U'Z', U'É', U'é', U'а', U'中' },
+	{ U'0', U'1', U'5', U'9', U'٣' },
+	{ U' ', U' ', U' ', U'\t', U'\n', U'\r', U'\v', U'\f', U' ', U' ', U'　' },
+	{ U'\'', U'\'', U'.', U',', U'!', U'-', U'(', U'"', U'_', U'€', U'¿', U'—' },
+};
+
+static std::string to_utf8(char32_t value) {
+	std::string result{};
+	if (value < 0x80) {
+		result += static_cast<char>(value);
+	} else if (value < 0x800) {
+		result += static_cast<char>(0xC0 | (value >> 6));
+		result += static_cast<char>(0x80 | (value & 0x3F));
+	} else {
+		result += static_cast<char>(0xE0 | (value >> 12));
+		result += static_cast<char>(0x80 | ((value >> 6) & 0x3F));
+		result += static_cast<char>(0x80 | (value & 0x3F));
+	}
+	return result;
+}
+
+// Mostly short mixed text, with long single-class runs mixed in so the 32-byte blocks see full runs, runs that end mid-block and runs broken
+// by a non-ASCII code point.
+static std::vector<char32_t> generate_text(std::mt19937_64& engine) {
+	std::vector<char32_t> text{};
+	const uint64_t run_count = engine() % 24;
+	for (uint64_t x = 0; x < run_count; ++x) {
+		const auto& code_points = code_point_classes[engine() % code_point_classes.size()];
+		const uint64_t length	= engine() % 8 == 0 ? 24 + engine() % 72 : 1 + engine() % 4;
+		const bool mixed		= engine() % 2 == 0;
+		const char32_t repeated = code_points[engine() % code_points.size()];
+		for (uint64_t y = 0; y < length; ++y) {
+			text.emplace_back(mixed ? code_points[engine() % code_points.size()] : repeated);
+		}
+	}
+	return text;
+}
+
+static std::vector<std::string> split_reference(const std::wregex& pattern, const std::vector<char32_t>& text) {
+	std::wstring wide{};
+	std::vector<uint64_t> offsets{ 0 };
+	std::string utf8{};
+	for (char32_t value: text) {
+		wide += static_cast<wchar_t>(value);
+		utf8 += to_utf8(value);
+		offsets.emplace_back(utf8.size());
+	}
+	std::vector<std::string> words{};
+	for (auto iterator = std::wsregex_iterator{ wide.begin(), wide.end(), pattern }; iterator != std::wsregex_iterator{}; ++iterator) {
+		const uint64_t begin = static_cast<uint64_t>(iterator->position());
+		const uint64_t end	 = begin + static_cast<uint64_t>(iterator->length());
+		words.emplace_back(utf8.substr(offsets[begin], offsets[end] - offsets[begin]));
+	}
+	return words;
+}
+
+static void print_words(const char* name, const std::vector<std::string>& words) {
+	std::cout << "  " << name << ":";
+	for (const auto& word: words) {
+		std::cout << " [" << word << "]";
+	}
+	std::cout << std::endl;
+}
+
+static bool check_classify_ascii_block(std::mt19937_64& engine) {
+	for (uint64_t x = 0; x < 100000; ++x) {
+		char block[nihilus::ascii_block_size]{};
+		for (auto& value: block) {
+			value = static_cast<char>(x % 2 == 0 ? engine() % 256 : engine() % 128);
+		}
+		const nihilus::ascii_block_masks masks = nihilus::classify_ascii_block(block);
+		for (uint64_t y = 0; y < nihilus::ascii_block_size; ++y) {
+			const uint8_t byte				 = static_cast<uint8_t>(block[y]);
+			const nihilus::unicode_class type = byte < 0x80 ? nihilus::ascii_classes[byte] : nihilus::unicode_class::end;
+			const bool expected[4]{ type == nihilus::unicode_class::letter, type == nihilus::unicode_class::number, type == nihilus::unicode_class::whitespace,
+				byte >= 0x80 };
+			const uint32_t got[4]{ masks.letter, masks.number, masks.whitespace, masks.non_ascii };
+			for (uint64_t z = 0; z < 4; ++z) {
+				if (((got[z] >> y) & 1) != expected[z]) {
+					std::cout << "classify_ascii_block: byte " << static_cast<uint32_t>(byte) << " at " << y << " misclassified (mask " << z << ")." << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	std::mt19937_64 engine{ 0x6e6968696c7573ull };
+#if defined(NIHILUS_AVX2) || defined(NIHILUS_AVX512)
+	std::cout << "pre_tokenizer: testing the AVX2 classification path." << std::endl;
+#elif defined(NIHILUS_NEON)
+	std::cout << "pre_tokenizer: testing the NEON classification path." << std::endl;
+#else
+	std::cout << "pre_tokenizer: testing the scalar classification path." << std::endl;
+#endif
+	if (!check_classify_ascii_block(engine)) {
+		return EXIT_FAILURE;
+	}
+	const std::wstring l{ letters };
+	const std::wstring n{ numbers };
+	const std::wstring s{ whitespace };
+	// (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+
+	const std::wregex pattern{ L"'(?:[sS]|[tT]|[rR][eE]|[vV][eE]|[mM]|[lL][lL]|[dD])|[^\\r\\n" + l + n + L"]?[" + l + L"]+|[" + n + L"]{1,3}| ?[^" + s + l + n +
+		L"]+[\\r\\n]*|[" + s + L"]*[\\r\\n]+|[" + s + L"]+(?![^" + s + L"])|[" + s + L"]+" };
+	for (uint64_t x = 0; x < 20000; ++x) {
+		const std::vector<char32_t> text = generate_text(engine);
+		std::string utf8{};
+		for (char32_t value: text) {
+			utf8 += to_utf8(value);
+		}
+		std::vector<std::string> words{};
+		tokenizer_probe::split_words(utf8, [&](std::string_view word) {
+			words.emplace_back(word);
+		});
+		const std::vector<std::string> expected = split_reference(pattern, text);
+		if (words != expected) {
+			std::cout << "pre_tokenizer: split mismatch on case " << x << ":" << std::endl;
+			print_words("expected", expected);
+			print_words("got", words);
+			return EXIT_FAILURE;
+		}
+	}
+	std::cout << "pre_tokenizer: 20000 generated texts split identically to the reference pattern." << std::endl;
+	return EXIT_SUCCESS;
+}
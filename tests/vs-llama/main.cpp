@@ -3,6 +3,7 @@
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -93,11 +94,155 @@ static void sigint_handler(int signo) {
 }
 #endif
 
+static void append_utf8(std::string& text, uint32_t value) {
+	if (value < 0x80) {
+		text += static_cast<char>(value);
+	} else if (value < 0x800) {
+		text += static_cast<char>(0xC0 | (value >> 6));
+		text += static_cast<char>(0x80 | (value & 0x3F));
+	} else if (value < 0x10000) {
+		text += static_cast<char>(0xE0 | (value >> 12));
+		text += static_cast<char>(0x80 | ((value >> 6) & 0x3F));
+		text += static_cast<char>(0x80 | (value & 0x3F));
+	} else {
+		text += static_cast<char>(0xF0 | (value >> 18));
+		text += static_cast<char>(0x80 | ((value >> 12) & 0x3F));
+		text += static_cast<char>(0x80 | ((value >> 6) & 0x3F));
+		text += static_cast<char>(0x80 | (value & 0x3F));
+	}
+}
+
+// Tokenizes a fixed set of edge cases, the prompt and a few thousand generated strings with both llama_tokenize and the nihilus tokenizer, with
+// and without special-token parsing, and stops at the first text whose ids differ.
+template<auto config> static bool check_tokenizer_parity(const nihilus::cli_params& cli_params) {
+	llama_model_params model_params = llama_model_default_params();
+	model_params.vocab_only			= true;
+	llama_model* vocab_model		= llama_model_load_from_file(std::string{ cli_params.model_file }.c_str(), model_params);
+	if (!vocab_model) {
+		std::cout << "tokenizer parity: llama.cpp failed to load " << cli_params.model_file << std::endl;
+		return false;
+	}
+	const llama_vocab* vocab = llama_model_get_vocab(vocab_model);
+	nihilus::memory_mapped_file model_data{};
+	model_data.init(cli_params.model_file);
+	nihilus::tokenizer<config.arch> tokenizer{};
+	tokenizer.init(nihilus::model_parser<config>::parse_tokenizer(model_data));
+
+	std::vector<std::string> texts{ "", " ", "  ", "\n", "\n\n\n", "\t", " \t\n ", "Hello world", " Hello world", "Hello  world  ", "hello\r\nworld",
+		"I'm you're we've they'll she'd it's IT'S DON'T", "'s 're ''ll", "1 12 123 1234 12345 1234567890", "3.14159 -42 +7e10", "a1b2c3 x_y-z",
+		"((()))[]{}<>!?.,;:...---", "def f(x):\n\treturn x  # comment\n", "¿Qué tal? naïve café Ünïcödé", "日本語のテキスト 中文 한국어",
+		"Привет, мир! Ελληνικά", "emoji 🙂👍🏽 and 🇺🇸 flags", "\u00a0non\u00a0breaking\u3000space", "<|begin_of_text|>hi<|eot_id|>",
+		"text<|start_header_id|>user<|end_header_id|>\n\nmore", std::string{ cli_params.prompt } };
+	std::mt19937_64 engine{ 0x746f6b656e73ull };
+	static constexpr uint32_t pieces[]{ 'a', 'Z', 'e', ' ', ' ', ' ', '\n', '\t', '\r', '\'', 's', '1', '9', '.', ',', '!', '-', '_', '<', '|', '>', 0xE9, 0xA0, 0x3000,
+		0x4E2D, 0x0663, 0x20AC, 0x1F642, 0x0301 };
+	for (uint64_t x = 0; x < 4096; ++x) {
+		std::string text{};
+		const uint64_t length = engine() % 64;
+		for (uint64_t y = 0; y < length; ++y) {
+			append_utf8(text, pieces[engine() % std::size(pieces)]);
+		}
+		texts.emplace_back(std::move(text));
+	}
+
+	std::vector<llama_token> expected{};
+	std::vector<int32_t> got{};
+	uint64_t checked{};
+	for (const auto& text: texts) {
+		for (const bool parse_special: { false, true }) {
+			expected.resize(text.size() + 2);
+			int32_t count = llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()), expected.data(), static_cast<int32_t>(expected.size()), true, parse_special);
+			if (count < 0) {
+				expected.resize(static_cast<uint64_t>(-count));
+				count = llama_tokenize(vocab, text.data(), static_cast<int32_t>(text.size()), expected.data(), static_cast<int32_t>(expected.size()), true, parse_special);
+			}
+			expected.resize(static_cast<uint64_t>(std::max(count, 0)));
+			got.clear();
+			tokenizer.tokenize(text, got, true, parse_special);
+			++checked;
+			if (!std::equal(expected.begin(), expected.end(), got.begin(), got.end())) {
+				std::cout << "tokenizer parity: mismatch (parse_special " << parse_special << ") on \"" << text << "\"" << std::endl << "  llama.cpp:";
+				for (const auto token: expected) {
+					std::cout << " " << token;
+				}
+				std::cout << std::endl << "  nihilus:  ";
+				for (const auto token: got) {
+					std::cout << " " << token;
+				}
+				std::cout << std::endl;
+				llama_model_free(vocab_model);
+				return false;
+			}
+		}
+	}
+	std::cout << "tokenizer parity: " << checked << " tokenizations match llama_tokenize token for token." << std::endl;
+	llama_model_free(vocab_model);
+	return true;
+}
+
+// Per-token cost of token_sampler over one row of the llama 3 vocabulary (128256 logits), for each mode execution_parameters selects. The peaked row
+// has a few clear winners over N(0, 2) noise, like a confident decode step; the flat row squeezes that noise to N(0, 0.1), so top-p without top-k
+// has to cover most of the vocabulary.
+static void benchmark_sampler() {
+	static constexpr uint64_t vocab_size{ 128256 };
+	static constexpr uint64_t sample_count{ 64 };
+	std::mt19937_64 engine{ 0x73616d706c65ull };
+	std::normal_distribution<float> noise{ 0.0f, 2.0f };
+	std::vector<float> peaked(vocab_size);
+	std::vector<float> flat(vocab_size);
+	for (uint64_t x = 0; x < vocab_size; ++x) {
+		peaked[x] = noise(engine);
+		flat[x]	  = peaked[x] * 0.05f;
+	}
+	for (uint64_t x = 0; x < 8; ++x) {
+		peaked[engine() % vocab_size] = 20.0f + static_cast<float>(x);
+	}
+	nihilus::token_sampler sampler{};
+	sampler.init(vocab_size);
+	int64_t checksum{};
+	const auto run = [&](const std::vector<float>& logits, float temperature, int32_t top_k, float top_p) {
+		nihilus::execution_parameters params{};
+		params.temperature = temperature;
+		params.top_k	   = top_k;
+		params.top_p	   = top_p;
+		params.random_seed = 0x5eedull;
+		for (uint64_t x = 0; x < sample_count; ++x) {
+			checksum += sampler.sample(logits.data(), vocab_size, params, x);
+		}
+		return static_cast<int32_t>(sample_count);
+	};
+	using stage = bnch_swt::benchmark_stage<"nihilus-sampler-128k", 8, 4, false, "Sample">;
+	stage::runBenchmark<"greedy", "cyan">([&] {
+		return run(peaked, 0.0f, 0, 1.0f);
+	});
+	stage::runBenchmark<"top-k 40", "cyan">([&] {
+		return run(peaked, 0.8f, 40, 1.0f);
+	});
+	stage::runBenchmark<"top-k 40, top-p 0.9", "cyan">([&] {
+		return run(peaked, 0.8f, 40, 0.9f);
+	});
+	stage::runBenchmark<"top-p 0.9 (peaked)", "cyan">([&] {
+		return run(peaked, 0.8f, 0, 0.9f);
+	});
+	stage::runBenchmark<"temperature only", "cyan">([&] {
+		return run(peaked, 0.8f, 0, 1.0f);
+	});
+	stage::runBenchmark<"top-p 0.9 (flat)", "cyan">([&] {
+		return run(flat, 0.8f, 0, 0.9f);
+	});
+	stage::printResults();
+	std::cout << "sampler checksum: " << checksum << std::endl;
+}
+
 int main(int argc, char** argv) {
 	try {
 		static constexpr auto model_config = nihilus::generate_model_config(nihilus::llama_model_generation::v3, nihilus::llama_model_size::llama_8B,
 			nihilus::kernel_type_profile::q8_gqa, nihilus::model_arch::llama, false);
 		auto cli_args_final				   = nihilus::harbinger<model_config>::parse_cli_arguments(argc, argv);
+		if (!check_tokenizer_parity<model_config>(cli_args_final)) {
+			return 1;
+		}
+		benchmark_sampler();
 		std::string return_value{};
 		bnch_swt::benchmark_stage<"nihilus-vs_llama.cpp", 2, 1, true, "Token">::runBenchmark<"llama.cpp", "cyan">([&] {
 			return_value.clear();
@@ -932,7 +1077,8 @@ int main(int argc, char** argv) {
 		});
 		bnch_swt::benchmark_stage<"nihilus-vs_llama.cpp", 2, 1, true, "Token">::runBenchmark<"nihilus", "cyan">([&] {
 			nihilus::model<model_config> model_graph_data{ cli_args_final };
-			nihilus::input_session_config session_config{ std::cin, 1024 };
+			const std::string grammar_source{ nihilus::get_grammar_source(cli_args_final) };
+			nihilus::input_session_config session_config{ std::cin, 1024, cli_args_final.prompt, grammar_source };
 			nihilus::input_session input_session{ session_config, model_graph_data };
 			input_session.exec_params.token_count  = cli_args_final.n_tokens;
 			input_session.exec_params.thread_count = cli_args_final.thread_count;